@@ -2,11 +2,11 @@
 
 layout (location = 0) in vec4 position;
 layout (location = 1) in vec2 tex_coord;
+layout (location = 3) in mat4 world;	//per instance, see ModelRenderer
 
 out vec2 frag_tex_coord;
 
 uniform mat4 projection_view;
-uniform mat4 world;
 
 void main()
 {
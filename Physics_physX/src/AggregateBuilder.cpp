@@ -0,0 +1,114 @@
+#include "AggregateBuilder.h"
+
+#include <cstdio>
+
+AggregateBuilder::AggregateBuilder()
+	: m_physics(nullptr),
+	m_scene(nullptr),
+	m_maxSize(0),
+	m_current(nullptr),
+	m_grouping(false),
+	m_selfCollision(false),
+	m_aggregateCount(0),
+	m_shapeCount(0)
+{}
+
+AggregateBuilder::~AggregateBuilder() {}
+
+void AggregateBuilder::create(PxPhysics* a_physics, PxScene* a_scene, unsigned int a_maxSize)
+{
+	//PhysX won't make aggregates bigger than this
+	const unsigned int maxAggregateSize = 128;
+
+	m_physics = a_physics;
+	m_scene = a_scene;
+	m_maxSize = PxMin(a_maxSize, maxAggregateSize);
+
+	if (a_maxSize > maxAggregateSize)
+		printf("Warning: aggregates hold at most %u actors\n", maxAggregateSize);
+}
+
+void AggregateBuilder::begin(bool a_selfCollision)
+{
+	end();
+
+	m_grouping = true;
+	m_selfCollision = a_selfCollision;
+}
+
+void AggregateBuilder::end()
+{
+	flush();
+	m_grouping = false;
+}
+
+void AggregateBuilder::add(PxRigidActor& a_actor)
+{
+	if (isEnabled() == false || (m_grouping == false && a_actor.getNbShapes() < 2))
+	{
+		m_scene->addActor(a_actor);
+		return;
+	}
+
+	//a compound on its own, its shapes can't collide with each other anyway
+	if (m_grouping == false)
+		m_selfCollision = false;
+
+	if (m_current != nullptr && m_current->getNbActors() >= m_maxSize)
+		flush();
+
+	if (m_current == nullptr)
+		m_current = m_physics->createAggregate(m_maxSize, m_selfCollision);
+
+	if (m_current == nullptr || m_current->addActor(a_actor) == false)
+	{
+		m_scene->addActor(a_actor);
+		return;
+	}
+
+	m_shapeCount += a_actor.getNbShapes();
+
+	if (m_grouping == false)
+		flush();
+}
+
+void AggregateBuilder::remove(PxRigidActor& a_actor)
+{
+	PxAggregate* aggregate = a_actor.getAggregate();
+
+	//taking it out of the scene detaches it from its aggregate as well, whereas removing it from
+	//the aggregate would put it back in the scene on its own
+	m_scene->removeActor(a_actor);
+
+	if (aggregate == nullptr)
+		return;
+
+	m_shapeCount -= PxMin(m_shapeCount, a_actor.getNbShapes());
+
+	//still being filled, flush drops it if it ends up empty
+	if (aggregate == m_current || aggregate->getNbActors() > 0)
+		return;
+
+	m_scene->removeAggregate(*aggregate);
+	aggregate->release();
+	m_aggregateCount--;
+}
+
+void AggregateBuilder::flush()
+{
+	if (m_current == nullptr)
+		return;
+
+	//adding it once it's full puts all its actors in the scene at once
+	if (m_current->getNbActors() > 0)
+	{
+		m_scene->addAggregate(*m_current);
+		m_aggregateCount++;
+	}
+	else
+	{
+		m_current->release();
+	}
+
+	m_current = nullptr;
+}
@@ -0,0 +1,53 @@
+#ifndef _AGGREGATEBUILDER_H_
+#define _AGGREGATEBUILDER_H_
+
+#include <PxPhysicsAPI.h>
+
+using namespace physx;
+
+//puts related actors (stacks, clusters of props, the shapes of one model) into PxAggregates so
+//the broadphase sees one box per group instead of one per shape, and only tests the members
+//against each other when the group's box is touched. groups bigger than the max size are split.
+//with a max size of 0 every actor goes straight into the scene as before.
+class AggregateBuilder
+{
+public:
+	AggregateBuilder();
+	~AggregateBuilder();
+
+	void create(PxPhysics* a_physics, PxScene* a_scene, unsigned int a_maxSize);
+
+	//actors added between begin and end share aggregates. a_selfCollision lets the members
+	//collide with each other, which stacks need and a single model doesn't
+	void begin(bool a_selfCollision);
+	void end();
+
+	//adds a_actor to the open group. outside a group compound actors get an aggregate of their
+	//own and single shape actors go straight into the scene
+	void add(PxRigidActor& a_actor);
+
+	//takes a_actor out of the scene and its aggregate, if it has one. an aggregate left
+	//empty is removed and released so it doesn't linger in the broadphase
+	void remove(PxRigidActor& a_actor);
+
+	bool isEnabled() const { return m_maxSize > 0; }
+
+	unsigned int getAggregateCount() const { return m_aggregateCount; }
+	unsigned int getShapeCount() const { return m_shapeCount; }	//shapes inside aggregates
+
+private:
+	void flush();
+
+	PxPhysics* m_physics;
+	PxScene* m_scene;
+	unsigned int m_maxSize;
+
+	PxAggregate* m_current;		//being filled, not in the scene until it is full or the group ends
+	bool m_grouping;
+	bool m_selfCollision;
+
+	unsigned int m_aggregateCount;
+	unsigned int m_shapeCount;
+};
+
+#endif // !_AGGREGATEBUILDER_H_
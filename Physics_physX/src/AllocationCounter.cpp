@@ -0,0 +1,147 @@
+#include "AllocationCounter.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#ifdef _WIN32
+#define ALLOCATION_THREAD_LOCAL __declspec(thread)
+#else
+#define ALLOCATION_THREAD_LOCAL __thread
+#endif
+
+static std::atomic<unsigned int> s_allocationCount(0);
+static ALLOCATION_THREAD_LOCAL unsigned int s_threadAllocationCount = 0;	//made by this thread alone
+static std::atomic<size_t> s_allocatedBytes(0);
+static std::atomic<size_t> s_peakAllocatedBytes(0);
+
+//each block from new starts with its size, padded so the memory handed out stays 16 byte aligned
+static const size_t HeaderSize = 16;
+
+unsigned int GetAllocationCount()
+{
+	return s_allocationCount;
+}
+
+unsigned int GetThreadAllocationCount()
+{
+	return s_threadAllocationCount;
+}
+
+void AddAllocationCount()
+{
+	s_allocationCount++;
+	s_threadAllocationCount++;
+}
+
+size_t GetAllocatedBytes()
+{
+	return s_allocatedBytes;
+}
+
+size_t GetPeakAllocatedBytes()
+{
+	return s_peakAllocatedBytes;
+}
+
+void ResetPeakAllocatedBytes()
+{
+	s_peakAllocatedBytes = s_allocatedBytes.load();
+}
+
+void AddAllocatedBytes(size_t a_size)
+{
+	size_t total = s_allocatedBytes += a_size;
+
+	//raise the peak unless another thread already raised it further
+	size_t peak = s_peakAllocatedBytes;
+	while (total > peak && s_peakAllocatedBytes.compare_exchange_weak(peak, total) == false) {}
+}
+
+void RemoveAllocatedBytes(size_t a_size)
+{
+	s_allocatedBytes -= a_size;
+}
+
+static void* CountedMalloc(size_t a_size)
+{
+	s_allocationCount++;
+	s_threadAllocationCount++;
+
+	char* block = (char*)malloc(a_size + HeaderSize);
+	if (block == nullptr)
+		return nullptr;
+
+	*(size_t*)block = a_size;
+	AddAllocatedBytes(a_size);
+
+	return block + HeaderSize;
+}
+
+static void CountedFree(void* a_pointer)
+{
+	if (a_pointer == nullptr)
+		return;
+
+	char* block = (char*)a_pointer - HeaderSize;
+	RemoveAllocatedBytes(*(size_t*)block);
+
+	free(block);
+}
+
+//replace the global allocation functions so every new is counted
+
+void* operator new(size_t a_size)
+{
+	void* pointer = CountedMalloc(a_size);
+	if (pointer == nullptr)
+		throw std::bad_alloc();
+
+	return pointer;
+}
+
+void* operator new[](size_t a_size)
+{
+	return operator new(a_size);
+}
+
+void* operator new(size_t a_size, const std::nothrow_t&) throw()
+{
+	return CountedMalloc(a_size);
+}
+
+void* operator new[](size_t a_size, const std::nothrow_t& a_nothrow) throw()
+{
+	return operator new(a_size, a_nothrow);
+}
+
+void operator delete(void* a_pointer) throw()
+{
+	CountedFree(a_pointer);
+}
+
+void operator delete[](void* a_pointer) throw()
+{
+	CountedFree(a_pointer);
+}
+
+//sized forms, used by compilers with sized deallocation, the size is in the header anyway
+void operator delete(void* a_pointer, size_t) throw()
+{
+	CountedFree(a_pointer);
+}
+
+void operator delete[](void* a_pointer, size_t) throw()
+{
+	CountedFree(a_pointer);
+}
+
+void operator delete(void* a_pointer, const std::nothrow_t&) throw()
+{
+	CountedFree(a_pointer);
+}
+
+void operator delete[](void* a_pointer, const std::nothrow_t&) throw()
+{
+	CountedFree(a_pointer);
+}
@@ -0,0 +1,22 @@
+#ifndef _ALLOCATIONCOUNTER_H_
+#define _ALLOCATIONCOUNTER_H_
+
+#include <cstddef>
+
+//counts every heap allocation made through new/delete, plus any others reported with
+//AddAllocationCount() (eg. PhysX's allocator), so we can check a frame doesn't allocate
+unsigned int GetAllocationCount();
+void AddAllocationCount();
+
+//the same, but only what the calling thread allocated
+unsigned int GetThreadAllocationCount();
+
+//bytes currently allocated through new/delete, plus any others reported with
+//AddAllocatedBytes(), and the most there has been since ResetPeakAllocatedBytes()
+size_t GetAllocatedBytes();
+size_t GetPeakAllocatedBytes();
+void ResetPeakAllocatedBytes();
+void AddAllocatedBytes(size_t a_size);
+void RemoveAllocatedBytes(size_t a_size);
+
+#endif // !_ALLOCATIONCOUNTER_H_
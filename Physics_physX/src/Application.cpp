@@ -3,7 +3,7 @@
 #include "GLFW/glfw3.h"
 #include <cstdio>
 
-Application::Application(){}
+Application::Application() : m_window(nullptr) {}
 Application::~Application(){}
 
 bool Application::startup()
@@ -0,0 +1,194 @@
+#include "AssetStreamer.h"
+
+#include "FBXActor.h"
+#include "Profiler.h"
+
+#include <chrono>
+#include <cstdio>
+
+AssetStreamer::AssetStreamer() : m_running(false), m_registry(nullptr), m_budgetMs(0), m_budgetBytes(0) {}
+
+AssetStreamer::~AssetStreamer()
+{
+	destroy();
+}
+
+void AssetStreamer::create(ResourceRegistry* a_registry, unsigned int a_threads, float a_budgetMs, size_t a_budgetBytes)
+{
+	m_registry = a_registry;
+	m_budgetMs = a_budgetMs;
+	m_budgetBytes = a_budgetBytes;
+
+	m_running = true;
+	for (unsigned int i = 0; i < a_threads; i++)
+		m_threads.push_back(std::thread(&AssetStreamer::loaderLoop, this));
+}
+
+void AssetStreamer::destroy()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_queueLock);
+		m_running = false;
+		m_queue.clear();
+	}
+	m_wake.notify_all();
+
+	for (auto& thread : m_threads)
+		thread.join();
+	m_threads.clear();
+
+	//unfinished models can be asked for again later
+	for (auto request : m_requests)
+	{
+		request->model->m_loading = false;
+		request->model->release();
+		delete request;
+	}
+	m_requests.clear();
+}
+
+void AssetStreamer::load(FBXActor* a_actor, const char* a_filename)
+{
+	bool load = false;
+	a_actor->SetModel(m_registry->acquireModel(a_filename, a_actor->m_vertexLayout, load));
+
+	//already there, or another request is bringing it in
+	if (load == false)
+		return;
+
+	Request* request = new Request();
+	request->model = a_actor->m_model;
+	request->filename = a_filename;
+	request->layout = a_actor->m_vertexLayout;
+	request->state = STATE_LOADING;
+	request->begun = false;
+	request->nextPiece = 0;
+
+	m_registry->retainModel(request->model);
+	m_requests.push_back(request);
+
+	//no loaders, load it here
+	if (m_threads.empty())
+	{
+		loadRequest(*request);
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(m_queueLock);
+		m_queue.push_back(request);
+	}
+	m_wake.notify_one();
+}
+
+void AssetStreamer::loaderLoop()
+{
+	Profiler::setThreadName("Loader");
+
+	while (true)
+	{
+		Request* request = nullptr;
+		{
+			std::unique_lock<std::mutex> lock(m_queueLock);
+			m_wake.wait(lock, [this]() { return m_running == false || m_queue.empty() == false; });
+
+			if (m_running == false)
+				return;
+
+			request = m_queue.front();
+			m_queue.pop_front();
+		}
+
+		loadRequest(*request);
+	}
+}
+
+void AssetStreamer::loadRequest(Request& a_request)
+{
+	PROFILE_ZONE("AssetStreamer::load");
+
+	//file reads, and the FBX import and decode when it needs baking, all happen here
+	bool loaded = a_request.cache.load(a_request.filename.c_str(), a_request.layout);
+	if (loaded)
+		a_request.cache.prefetch();
+
+	a_request.state.store(loaded ? STATE_STAGED : STATE_FAILED, std::memory_order_release);
+}
+
+void AssetStreamer::update()
+{
+	PROFILE_ZONE("AssetStreamer::update");
+
+	typedef std::chrono::high_resolution_clock Clock;
+	Clock::time_point start = Clock::now();
+
+	size_t bytes = 0;
+	bool uploaded = false;
+
+	for (unsigned int i = 0; i < m_requests.size();)
+	{
+		Request& request = *m_requests[i];
+		int state = request.state.load(std::memory_order_acquire);
+
+		if (state == STATE_FAILED)
+		{
+			printf("Error: Failed to stream %s\n", request.filename.c_str());
+			request.model->m_loading = false;
+			request.model->release();
+			delete m_requests[i];
+			m_requests.erase(m_requests.begin() + i);
+			continue;
+		}
+
+		if (state == STATE_LOADING)
+		{
+			i++;
+			continue;
+		}
+
+		//a piece at a time until the budget runs out, always at least one a frame so big
+		//textures still get through
+		bool finished = false;
+		while (finished == false)
+		{
+			double elapsed = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+			if (uploaded && (elapsed >= m_budgetMs || bytes >= m_budgetBytes))
+				return;
+
+			finished = uploadPiece(request, bytes);
+			uploaded = true;
+		}
+
+		//ready the moment its last piece is up, not a frame later when the budget allows
+		request.model->m_ready = true;
+		request.model->m_loading = false;
+		request.model->release();
+		delete m_requests[i];
+		m_requests.erase(m_requests.begin() + i);
+	}
+}
+
+bool AssetStreamer::uploadPiece(Request& a_request, size_t& a_bytes)
+{
+	ModelResource* model = a_request.model;
+	const MeshCache::Header& header = a_request.cache.getHeader();
+
+	//the bounds are known now, so the placeholder can be the right size
+	if (a_request.begun == false)
+	{
+		model->beginUpload(a_request.cache);
+		a_request.begun = true;
+	}
+
+	unsigned int piece = a_request.nextPiece++;
+	unsigned int pieceCount = 1 + header.textureCount + header.meshCount;
+
+	if (piece == 0)
+		model->createProgram();
+	else if (piece - 1 < header.textureCount)
+		a_bytes += model->uploadTexture(a_request.cache, piece - 1);
+	else if (piece - 1 - header.textureCount < header.meshCount)
+		a_bytes += model->uploadMesh(a_request.cache, piece - 1 - header.textureCount);
+
+	return a_request.nextPiece >= pieceCount;
+}
@@ -0,0 +1,87 @@
+#ifndef _ASSETSTREAMER_H_
+#define _ASSETSTREAMER_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "MeshCache.h"
+#include "ResourceRegistry.h"
+
+class FBXActor;
+
+//loads models without stalling the frame. a loader thread opens (or bakes) the model's MeshCache
+//and reads it into memory, then update() on the GL thread uploads the program, textures and meshes
+//a piece at a time until the frame's time or byte budget is spent. actors draw a placeholder
+//box until their model's last piece is uploaded. models come from a ResourceRegistry, so a model
+//already loaded or on its way is shared rather than loaded again.
+//the loaders are our own threads rather than TaskPool jobs, as the main thread helps out with
+//queued jobs whenever it waits on the pool and could pick up a whole FBX import.
+class AssetStreamer
+{
+public:
+	AssetStreamer();
+	~AssetStreamer();
+
+	//a_budgetMs and a_budgetBytes limit the uploads each update, at least one piece always goes.
+	//with no threads loads happen in load() itself
+	void create(ResourceRegistry* a_registry, unsigned int a_threads, float a_budgetMs, size_t a_budgetBytes);
+
+	//finishes the loads already running, drops the rest and anything not uploaded
+	void destroy();
+
+	//gives a_actor a_filename's model, streaming it in if nothing has loaded it yet
+	void load(FBXActor* a_actor, const char* a_filename);
+
+	//uploads whatever the workers have finished with, call once a frame on the GL thread
+	void update();
+
+	unsigned int getPendingCount() const { return (unsigned int)m_requests.size(); }
+
+private:
+	enum State
+	{
+		STATE_LOADING,		//queued or on a loader thread
+		STATE_STAGED,		//in memory, waiting for uploads
+		STATE_FAILED,
+	};
+
+	struct Request
+	{
+		ModelResource* model;	//holds a reference until the request is done
+		std::string filename;
+		CompactMesh::Layout layout;
+		MeshCache cache;
+		std::atomic<int> state;
+
+		//upload progress: the program, then textures, then meshes
+		bool begun;
+		unsigned int nextPiece;
+	};
+
+	void loaderLoop();
+	static void loadRequest(Request& a_request);
+
+	//uploads a_request's next piece, true once that was its last
+	bool uploadPiece(Request& a_request, size_t& a_bytes);
+
+	//loader threads
+	std::vector<std::thread> m_threads;
+	std::deque<Request*> m_queue;		//waiting for a loader
+	std::mutex m_queueLock;
+	std::condition_variable m_wake;
+	bool m_running;
+
+	ResourceRegistry* m_registry;
+
+	float m_budgetMs;
+	size_t m_budgetBytes;
+
+	std::vector<Request*> m_requests;	//in the order they were asked for
+};
+
+#endif // !_ASSETSTREAMER_H_
@@ -0,0 +1,371 @@
+#include "Benchmark.h"
+
+#include "PhysicsDemoScene.h"
+#include "AllocationCounter.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+
+Benchmark::Benchmark() : m_shotsFired(0)
+{
+	const PxBroadPhaseType::Enum SAP = PxBroadPhaseType::eSAP;
+	const PxBroadPhaseType::Enum MBP = PxBroadPhaseType::eMBP;
+
+	//name, scale, projectile pool, setup, per step input, broadphase, aggregate size
+	Scenario boxStacks = { "boxStacks", 16, 0, &Benchmark::setupBoxStacks, nullptr, SAP, 0 };
+	Scenario sphereRain = { "sphereRain", 512, 512, &Benchmark::setupSphereRain, &Benchmark::stepSphereRain, SAP, 0 };
+	Scenario compoundActors = { "compoundActors", 128, 0, &Benchmark::setupCompoundActors, nullptr, SAP, 0 };
+	Scenario crowd = { "crowd", 64, 0, &Benchmark::setupCrowd, &Benchmark::stepCrowd, SAP, 0 };
+
+	//the same thousands of projectiles spread over a large area with each broadphase
+	Scenario wideRainSAP = { "wideRainSAP", 4096, 4096, &Benchmark::setupSphereRain, &Benchmark::stepWideRain, SAP, 0 };
+	Scenario wideRainMBP = { "wideRainMBP", 4096, 4096, &Benchmark::setupSphereRain, &Benchmark::stepWideRain, MBP, 0 };
+
+	//dense clusters with each stack or row of models in aggregates
+	Scenario boxStacksAgg = { "boxStacksAgg", 16, 0, &Benchmark::setupBoxStacks, nullptr, SAP, 64 };
+	Scenario compoundActorsAgg = { "compoundActorsAgg", 128, 0, &Benchmark::setupCompoundActors, nullptr, SAP, 64 };
+
+	m_scenarios.push_back(boxStacks);
+	m_scenarios.push_back(sphereRain);
+	m_scenarios.push_back(compoundActors);
+	m_scenarios.push_back(crowd);
+	m_scenarios.push_back(wideRainSAP);
+	m_scenarios.push_back(wideRainMBP);
+	m_scenarios.push_back(boxStacksAgg);
+	m_scenarios.push_back(compoundActorsAgg);
+}
+
+Benchmark::~Benchmark() {}
+
+bool Benchmark::run(const char* a_scenario, unsigned int a_steps, unsigned int a_workerThreads)
+{
+	bool all = strcmp(a_scenario, "all") == 0;
+	bool found = false;
+
+	for (auto& scenario : m_scenarios)
+	{
+		if (all || strcmp(a_scenario, scenario.name) == 0)
+		{
+			found = true;
+			if (runScenario(scenario, a_steps, a_workerThreads) == false)
+				return false;
+		}
+	}
+
+	if (found == false)
+	{
+		printf("Unknown benchmark scenario '%s', expected one of:", a_scenario);
+		for (auto& scenario : m_scenarios)
+			printf(" %s", scenario.name);
+		printf(" all\n");
+	}
+
+	return found;
+}
+
+bool Benchmark::runScenario(const Scenario& a_scenario, unsigned int a_steps, unsigned int a_workerThreads)
+{
+	typedef std::chrono::high_resolution_clock Clock;
+
+	printf("Running %s (scale %u, %u steps)\n", a_scenario.name, a_scenario.scale, a_steps);
+
+	size_t baseBytes = GetAllocatedBytes();
+	ResetPeakAllocatedBytes();
+
+	//a fresh scene each run so scenarios don't affect each other
+	PhysicsDemoScene* scene = new PhysicsDemoScene();
+	scene->m_headless = true;
+	scene->m_workerThreads = a_workerThreads;
+	scene->m_broadPhaseType = a_scenario.broadPhase;
+	scene->m_aggregateSize = a_scenario.aggregateSize;
+	if (a_scenario.projectiles > 0)
+		scene->m_maxProjectiles = a_scenario.projectiles;
+
+	if (scene->startup() == false)
+	{
+		delete scene;
+		return false;
+	}
+
+	m_shotsFired = 0;
+	(this->*a_scenario.setup)(*scene, a_scenario.scale);
+
+	std::vector<double> stepTimes;
+	stepTimes.reserve(a_steps);
+
+	double fetchWait = 0;
+
+	for (unsigned int i = 0; i < a_steps; i++)
+	{
+		//the scripted input counts, it's most of the work in the crowd and rain scenarios
+		Clock::time_point start = Clock::now();
+
+		if (a_scenario.step != nullptr)
+			(this->*a_scenario.step)(*scene, a_scenario.scale, i);
+
+		scene->stepHeadless();
+
+		stepTimes.push_back(std::chrono::duration<double, std::milli>(Clock::now() - start).count());
+		fetchWait += scene->m_fetchWaitTime;
+	}
+
+	Result result;
+	result.name = a_scenario.name;
+	result.broadPhase = a_scenario.broadPhase == PxBroadPhaseType::eMBP ? "mbp" : "sap";
+	result.scale = a_scenario.scale;
+	result.steps = a_steps;
+	result.bodies = scene->m_renderState.getBodyCount();
+	result.volumes = 0;
+	result.contactPairs = 0;
+	if (scene->m_simStats.getSampleCount() > 0)
+	{
+		result.volumes = scene->m_simStats.getSample(0).broadphaseVolumes;
+		result.contactPairs = scene->m_simStats.getSample(0).contactPairs;
+	}
+	result.meanStep = 0;
+	result.p50Step = 0;
+	result.p99Step = 0;
+	result.maxStep = 0;
+	result.meanFetchWait = 0;
+
+	if (a_steps > 0)
+	{
+		double total = 0;
+		for (auto time : stepTimes)
+			total += time;
+
+		std::sort(stepTimes.begin(), stepTimes.end());
+
+		result.meanStep = total / a_steps;
+		result.p50Step = stepTimes[(a_steps - 1) * 50 / 100];
+		result.p99Step = stepTimes[(a_steps - 1) * 99 / 100];
+		result.maxStep = stepTimes.back();
+		result.meanFetchWait = fetchWait / a_steps;
+	}
+
+	//controllers have to go before their manager
+	for (auto controller : m_crowd)
+		controller->release();
+	m_crowd.clear();
+
+	scene->shutdown();
+	delete scene;
+
+	//the actors' userData pointed at these
+	for (auto model : m_models)
+		delete model;
+	m_models.clear();
+
+	size_t peakBytes = GetPeakAllocatedBytes();
+	result.peakBytes = peakBytes > baseBytes ? peakBytes - baseBytes : 0;
+
+	m_results.push_back(result);
+	return true;
+}
+
+void Benchmark::print() const
+{
+	printf("%-18s %4s %8s %8s %8s %8s %8s %10s %10s %10s %10s %10s %12s\n",
+		"scenario", "bp", "scale", "steps", "bodies", "volumes", "pairs", "mean ms", "p50 ms", "p99 ms", "max ms", "fetch ms", "peak KB");
+
+	for (auto& result : m_results)
+	{
+		printf("%-18s %4s %8u %8u %8u %8u %8u %10.4f %10.4f %10.4f %10.4f %10.4f %12u\n",
+			result.name.c_str(), result.broadPhase, result.scale, result.steps, result.bodies, result.volumes, result.contactPairs,
+			result.meanStep, result.p50Step, result.p99Step, result.maxStep, result.meanFetchWait,
+			(unsigned int)(result.peakBytes / 1024));
+	}
+}
+
+bool Benchmark::writeCSV(const char* a_filename) const
+{
+	FILE* file = fopen(a_filename, "w");
+	if (file == nullptr)
+	{
+		printf("Error: Failed to open %s for writing\n", a_filename);
+		return false;
+	}
+
+	fprintf(file, "scenario,broadphase,scale,steps,bodies,broadphase_volumes,contact_pairs,mean_ms,p50_ms,p99_ms,max_ms,fetch_wait_ms,peak_bytes\n");
+
+	for (auto& result : m_results)
+	{
+		fprintf(file, "%s,%s,%u,%u,%u,%u,%u,%.6f,%.6f,%.6f,%.6f,%.6f,%llu\n",
+			result.name.c_str(), result.broadPhase, result.scale, result.steps, result.bodies, result.volumes, result.contactPairs,
+			result.meanStep, result.p50Step, result.p99Step, result.maxStep, result.meanFetchWait,
+			(unsigned long long)result.peakBytes);
+	}
+
+	fclose(file);
+	return true;
+}
+
+bool Benchmark::writeJSON(const char* a_filename) const
+{
+	FILE* file = fopen(a_filename, "w");
+	if (file == nullptr)
+	{
+		printf("Error: Failed to open %s for writing\n", a_filename);
+		return false;
+	}
+
+	fprintf(file, "{\n\t\"scenarios\": [\n");
+
+	for (unsigned int i = 0; i < m_results.size(); i++)
+	{
+		const Result& result = m_results[i];
+
+		fprintf(file, "\t\t{ \"name\": \"%s\", \"broadphase\": \"%s\", \"scale\": %u, \"steps\": %u, \"bodies\": %u, "
+			"\"broadphaseVolumes\": %u, \"contactPairs\": %u, \"meanMs\": %.6f, \"p50Ms\": %.6f, \"p99Ms\": %.6f, \"maxMs\": %.6f, \"fetchWaitMs\": %.6f, \"peakBytes\": %llu }%s\n",
+			result.name.c_str(), result.broadPhase, result.scale, result.steps, result.bodies, result.volumes, result.contactPairs,
+			result.meanStep, result.p50Step, result.p99Step, result.maxStep, result.meanFetchWait,
+			(unsigned long long)result.peakBytes, i + 1 < m_results.size() ? "," : "");
+	}
+
+	fprintf(file, "\t]\n}\n");
+
+	fclose(file);
+	return true;
+}
+
+//scenarios
+
+void Benchmark::setupBoxStacks(PhysicsDemoScene& a_scene, unsigned int a_scale)
+{
+	//a_scale stacks of ten boxes on a square grid, like the tutorial box
+	const unsigned int height = 10;
+	const float halfExtent = 0.5f;
+	const float density = 100;
+
+	unsigned int columns = (unsigned int)ceilf(sqrtf((float)a_scale));
+
+	PxBoxGeometry box(halfExtent, halfExtent, halfExtent);
+
+	for (unsigned int stack = 0; stack < a_scale; stack++)
+	{
+		float x = ((stack % columns) - columns * 0.5f) * 3.0f;
+		float z = ((stack / columns) - columns * 0.5f) * 3.0f + 10.0f;	//clear of the player
+
+		//a stack's boxes rest on each other, so they have to collide within the aggregate
+		a_scene.m_aggregates.begin(true);
+
+		for (unsigned int level = 0; level < height; level++)
+		{
+			PxTransform transform(PxVec3(x, halfExtent + level * halfExtent * 2, z));
+			PxRigidDynamic* actor = PxCreateDynamic(*a_scene.g_Physics, transform, box, *a_scene.g_PhysicsMaterial, density);
+
+			a_scene.m_aggregates.add(*actor);
+			a_scene.g_PhysXActors.push_back(actor);
+		}
+
+		a_scene.m_aggregates.end();
+	}
+}
+
+void Benchmark::setupSphereRain(PhysicsDemoScene& a_scene, unsigned int a_scale)
+{
+	//everything happens in stepSphereRain
+}
+
+void Benchmark::stepSphereRain(PhysicsDemoScene& a_scene, unsigned int a_scale, unsigned int a_step)
+{
+	//a few shots a step until a_scale projectiles have been fired, from a grid of
+	//points above the ground looking straight down
+	const unsigned int shotsPerStep = 4;
+
+	for (unsigned int i = 0; i < shotsPerStep && m_shotsFired < a_scale; i++, m_shotsFired++)
+	{
+		float x = ((m_shotsFired % 16) - 8.0f) * 2.0f;
+		float z = (((m_shotsFired / 16) % 16) - 8.0f) * 2.0f;
+		float y = 20.0f + (m_shotsFired / 256) * 2.0f;
+
+		a_scene.m_camera.setLookAt(vec3(x, y, z), vec3(x, 0, z), vec3(0, 0, 1));
+		a_scene.shootSphere();
+	}
+}
+
+void Benchmark::stepWideRain(PhysicsDemoScene& a_scene, unsigned int a_scale, unsigned int a_step)
+{
+	//like stepSphereRain but faster and from a 64 by 64 grid spread over most of the
+	//default world, so the broadphase has thousands of bodies far apart from each other
+	const unsigned int shotsPerStep = 16;
+	const float spacing = 7.0f;
+
+	for (unsigned int i = 0; i < shotsPerStep && m_shotsFired < a_scale; i++, m_shotsFired++)
+	{
+		float x = ((m_shotsFired % 64) - 32.0f) * spacing;
+		float z = (((m_shotsFired / 64) % 64) - 32.0f) * spacing;
+		float y = 30.0f;
+
+		a_scene.m_camera.setLookAt(vec3(x, y, z), vec3(x, 0, z), vec3(0, 0, 1));
+		a_scene.shootSphere();
+	}
+}
+
+void Benchmark::setupCompoundActors(PhysicsDemoScene& a_scene, unsigned int a_scale)
+{
+	//the soulspear's collision shapes without its model, stacked in layers of 64
+	for (unsigned int i = 0; i < a_scale; i++)
+	{
+		//each row of 8 is one group
+		if (i % 8 == 0)
+			a_scene.m_aggregates.begin(true);
+
+		float x = ((i % 8) - 4.0f) * 3.0f;
+		float y = 1.0f + (i / 64) * 10.0f;
+		float z = (((i / 8) % 8) - 4.0f) * 3.0f - 20.0f;
+
+		FBXActor* model = new FBXActor();
+		model->m_world = glm::translate(vec3(x, y, z));
+		model->createCollisionShapes(&a_scene);
+
+		m_models.push_back(model);
+	}
+
+	a_scene.m_aggregates.end();
+}
+
+void Benchmark::setupCrowd(PhysicsDemoScene& a_scene, unsigned int a_scale)
+{
+	//characters the same size as the player, on a grid
+	unsigned int columns = (unsigned int)ceilf(sqrtf((float)a_scale));
+
+	PxCapsuleControllerDesc desc;
+	desc.height = 3.0f;
+	desc.radius = 0.6f;
+	desc.material = a_scene.playerPhysicsMaterial;
+	desc.density = 10;
+
+	for (unsigned int i = 0; i < a_scale; i++)
+	{
+		float x = ((i % columns) - columns * 0.5f) * 3.0f + 20.0f;
+		float z = ((i / columns) - columns * 0.5f) * 3.0f;
+
+		desc.position.set(x, 2.5f, z);
+
+		PxController* controller = a_scene.gCharacterManager->createController(desc);
+		if (controller != nullptr)
+			m_crowd.push_back(controller);
+	}
+}
+
+void Benchmark::stepCrowd(PhysicsDemoScene& a_scene, unsigned int a_scale, unsigned int a_step)
+{
+	//each character walks its own slowly turning circle
+	const float speed = 5.0f;
+	const float gravity = -10.0f;
+
+	float dt = a_scene.m_fixedTimeStep;
+
+	PxControllerFilters filter;
+
+	for (unsigned int i = 0; i < m_crowd.size(); i++)
+	{
+		float angle = i * 0.5f + a_step * 0.02f;
+		PxVec3 displacement(cosf(angle) * speed * dt, gravity * dt, sinf(angle) * speed * dt);
+
+		m_crowd[i]->move(displacement, 0.001f, dt, filter);
+	}
+}
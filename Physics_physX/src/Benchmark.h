@@ -0,0 +1,84 @@
+#ifndef _BENCHMARK_H_
+#define _BENCHMARK_H_
+
+#include <PxPhysicsAPI.h>
+
+#include <string>
+#include <vector>
+
+using namespace physx;
+
+class PhysicsDemoScene;
+class FBXActor;
+
+//builds scripted scenes on top of the demo scene's setup functions, runs each one headless
+//for a fixed number of steps and reports the step times, so runs can be compared over time
+class Benchmark
+{
+public:
+	struct Result
+	{
+		std::string name;
+		const char* broadPhase;		//"sap" or "mbp"
+		unsigned int scale;			//how many stacks, projectiles, actors or characters
+		unsigned int steps;
+		unsigned int bodies;		//rigid bodies tracked at the end of the run
+		unsigned int volumes;		//broadphase entries at the end of the run
+		unsigned int contactPairs;	//in the last step
+		double meanStep;			//ms, including the scenario's scripted input
+		double p50Step;
+		double p99Step;
+		double maxStep;
+		double meanFetchWait;		//ms per step blocked in fetchResults
+		size_t peakBytes;			//heap high-water mark above where the scenario started
+	};
+
+	Benchmark();
+	~Benchmark();
+
+	//runs the named scenario, or every scenario for "all". false if the name is unknown
+	//or a scene failed to start
+	bool run(const char* a_scenario, unsigned int a_steps, unsigned int a_workerThreads);
+
+	void print() const;
+	bool writeCSV(const char* a_filename) const;
+	bool writeJSON(const char* a_filename) const;
+
+	const std::vector<Result>& getResults() const { return m_results; }
+
+private:
+	typedef void (Benchmark::*SetupFunction)(PhysicsDemoScene& a_scene, unsigned int a_scale);
+	typedef void (Benchmark::*StepFunction)(PhysicsDemoScene& a_scene, unsigned int a_scale, unsigned int a_step);
+
+	struct Scenario
+	{
+		const char* name;
+		unsigned int scale;
+		unsigned int projectiles;	//projectile pool size, 0 keeps the scene default
+		SetupFunction setup;
+		StepFunction step;			//scripted input before each step, can be null
+		PxBroadPhaseType::Enum broadPhase;
+		unsigned int aggregateSize;	//0 for no aggregates
+	};
+
+	bool runScenario(const Scenario& a_scenario, unsigned int a_steps, unsigned int a_workerThreads);
+
+	//scenarios
+	void setupBoxStacks(PhysicsDemoScene& a_scene, unsigned int a_scale);
+	void setupSphereRain(PhysicsDemoScene& a_scene, unsigned int a_scale);
+	void stepSphereRain(PhysicsDemoScene& a_scene, unsigned int a_scale, unsigned int a_step);
+	void stepWideRain(PhysicsDemoScene& a_scene, unsigned int a_scale, unsigned int a_step);
+	void setupCompoundActors(PhysicsDemoScene& a_scene, unsigned int a_scale);
+	void setupCrowd(PhysicsDemoScene& a_scene, unsigned int a_scale);
+	void stepCrowd(PhysicsDemoScene& a_scene, unsigned int a_scale, unsigned int a_step);
+
+	std::vector<Scenario> m_scenarios;
+	std::vector<Result> m_results;
+
+	//per scenario state, cleared after each run
+	std::vector<FBXActor*> m_models;
+	std::vector<PxController*> m_crowd;
+	unsigned int m_shotsFired;
+};
+
+#endif // !_BENCHMARK_H_
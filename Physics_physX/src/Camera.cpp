@@ -39,8 +39,21 @@ void Camera::setPosition(vec3 pos)
 
 vec3 Camera::pickAgainstPlane(float x, float y, vec4 plane)
 {
-	float nxPos = x / 1280.0f; //replace these with your screen width and height
-	float nyPos = y / 720.0f;
+	vec3 cam_pos, dir;
+	getPickRay(x, y, 1280.0f, 720.0f, cam_pos, dir); //replace these with your screen width and height
+
+	float t = -(glm::dot(cam_pos, plane.xyz()) + plane.w)
+		/ (glm::dot(dir, plane.xyz()));
+
+	vec3 result = cam_pos + dir * t;
+
+	return result;
+}
+
+void Camera::getPickRay(float x, float y, float width, float height, vec3& origin, vec3& direction)
+{
+	float nxPos = x / width;
+	float nyPos = y / height;
 
 	float sxPos = nxPos - 0.5f;
 	float syPos = nyPos - 0.5f;
@@ -55,15 +68,8 @@ vec3 Camera::pickAgainstPlane(float x, float y, vec4 plane)
 
 	world_pos /= world_pos.w;
 
-	vec3 cam_pos = world[3].xyz(); //world is the member variable
-	vec3 dir = world_pos.xyz() - cam_pos;
-
-	float t = -(glm::dot(cam_pos, plane.xyz()) + plane.w)
-		/ (glm::dot(dir, plane.xyz()));
-
-	vec3 result = cam_pos + dir * t;
-
-	return result;
+	origin = world[3].xyz(); //world is the member variable
+	direction = glm::normalize(world_pos.xyz() - origin);
 }
 
 FlyCamera::FlyCamera(float aspect, float new_speed) : Camera(aspect)
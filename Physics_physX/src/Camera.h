@@ -24,6 +24,9 @@ public:
 
     vec3 pickAgainstPlane(float x, float y, vec4 plane);
 
+	//ray from the camera through the cursor at x, y on a width by height screen, direction is normalised
+	void getPickRay(float x, float y, float width, float height, vec3& origin, vec3& direction);
+
 	mat4 world;
 	mat4 view;
 	mat4 proj;
@@ -0,0 +1,365 @@
+#include "CompactMesh.h"
+
+#include "gl_core_4_4.h"
+
+#include <cmath>
+#include <cstring>
+
+namespace
+{
+	//vertex cache modelled by optimiseVertexCache, bigger than real caches so it suits most hardware
+	const int CACHE_SIZE = 32;
+	const unsigned int NOT_CACHED = 0xffffffff;
+
+	float vertexScore(int a_cachePosition, unsigned int a_remaining)
+	{
+		//no triangles left, nothing to gain from picking it
+		if (a_remaining == 0)
+			return -1.0f;
+
+		float score = 0;
+
+		if (a_cachePosition >= 0)
+		{
+			//the last triangle's vertices score the same, so which of them it starts with doesn't matter
+			if (a_cachePosition < 3)
+				score = 0.75f;
+			else
+				score = powf(1.0f - (float)(a_cachePosition - 3) / (CACHE_SIZE - 3), 1.5f);
+		}
+
+		//finish off vertices with few triangles left so they can leave the cache
+		score += 2.0f * powf((float)a_remaining, -0.5f);
+
+		return score;
+	}
+
+	unsigned int packNormal(const glm::vec4& a_normal)
+	{
+		//GL_INT_2_10_10_10_REV, x in the low bits
+		vec3 n = glm::clamp(vec3(a_normal), vec3(-1), vec3(1));
+
+		int x = (int)roundf(n.x * 511.0f);
+		int y = (int)roundf(n.y * 511.0f);
+		int z = (int)roundf(n.z * 511.0f);
+
+		return (x & 0x3ff) | ((y & 0x3ff) << 10) | ((z & 0x3ff) << 20);
+	}
+}
+
+CompactMesh::CompactMesh() : m_indexCount(0)
+{
+	m_format.vertexSize = 0;
+	m_format.texCoord = TEXCOORD_FLOAT;
+	m_format.normals = false;
+	m_format.shortIndices = true;
+}
+
+CompactMesh::~CompactMesh() {}
+
+void CompactMesh::build(const std::vector<FBXVertex>& a_vertices, const std::vector<unsigned int>& a_indices, const Layout& a_layout)
+{
+	unsigned int vertexCount = (unsigned int)a_vertices.size();
+
+	//drop any triangle which points past the vertices rather than read garbage
+	std::vector<unsigned int> indices;
+	indices.reserve(a_indices.size());
+	for (size_t i = 0; i + 2 < a_indices.size(); i += 3)
+	{
+		if (a_indices[i] < vertexCount && a_indices[i + 1] < vertexCount && a_indices[i + 2] < vertexCount)
+			indices.insert(indices.end(), a_indices.begin() + i, a_indices.begin() + i + 3);
+	}
+
+	optimiseVertexCache(indices, vertexCount);
+
+	//vertices in the order the triangles first use them, unused ones dropped
+	std::vector<unsigned int> remap(vertexCount, NOT_CACHED);
+	std::vector<unsigned int> order;
+	order.reserve(vertexCount);
+
+	for (auto& index : indices)
+	{
+		if (remap[index] == NOT_CACHED)
+		{
+			remap[index] = (unsigned int)order.size();
+			order.push_back(index);
+		}
+		index = remap[index];
+	}
+
+	//unorm can't hold coordinates which tile
+	m_format.texCoord = a_layout.texCoord;
+	if (m_format.texCoord == TEXCOORD_UNORM16)
+	{
+		for (auto vertex : order)
+		{
+			const vec2& uv = a_vertices[vertex].texCoord1;
+			if (uv.x < 0 || uv.x > 1 || uv.y < 0 || uv.y > 1)
+			{
+				m_format.texCoord = TEXCOORD_HALF;
+				break;
+			}
+		}
+	}
+
+	m_format.normals = a_layout.normals;
+
+	unsigned int texCoordSize = m_format.texCoord == TEXCOORD_FLOAT ? sizeof(vec2) : sizeof(unsigned int);
+	m_format.vertexSize = sizeof(float) * 3 + texCoordSize + (m_format.normals ? sizeof(unsigned int) : 0);
+
+	//pack
+	m_vertices.resize(order.size() * m_format.vertexSize);
+	unsigned char* out = m_vertices.data();
+
+	for (auto vertex : order)
+	{
+		const FBXVertex& source = a_vertices[vertex];
+
+		memcpy(out, &source.position, sizeof(float) * 3);
+		out += sizeof(float) * 3;
+
+		if (m_format.texCoord == TEXCOORD_FLOAT)
+		{
+			memcpy(out, &source.texCoord1, sizeof(vec2));
+		}
+		else
+		{
+			unsigned int packed = m_format.texCoord == TEXCOORD_HALF ? glm::packHalf2x16(source.texCoord1) : glm::packUnorm2x16(source.texCoord1);
+			memcpy(out, &packed, sizeof(packed));
+		}
+		out += texCoordSize;
+
+		if (m_format.normals)
+		{
+			unsigned int packed = packNormal(source.normal);
+			memcpy(out, &packed, sizeof(packed));
+			out += sizeof(packed);
+		}
+	}
+
+	//indices
+	m_indexCount = (unsigned int)indices.size();
+	m_format.shortIndices = order.size() <= 0x10000;
+
+	if (m_format.shortIndices)
+	{
+		m_indices.resize(indices.size() * sizeof(unsigned short));
+		unsigned short* shortIndices = (unsigned short*)m_indices.data();
+		for (size_t i = 0; i < indices.size(); i++)
+			shortIndices[i] = (unsigned short)indices[i];
+	}
+	else
+	{
+		m_indices.resize(indices.size() * sizeof(unsigned int));
+		if (indices.empty() == false)
+			memcpy(m_indices.data(), indices.data(), m_indices.size());
+	}
+}
+
+void CompactMesh::upload(ShaderObjs::OpenGLData& a_data) const
+{
+	upload(a_data, m_format, m_vertices.data(), m_vertices.size(), m_indices.data(), m_indexCount);
+}
+
+void CompactMesh::upload(ShaderObjs::OpenGLData& a_data, const Format& a_format, const void* a_vertices, size_t a_vertexBytes,
+						 const void* a_indices, unsigned int a_indexCount)
+{
+	a_data.IndexCount = a_indexCount;
+	a_data.IndexType = a_format.shortIndices ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+
+	size_t indexBytes = a_indexCount * (a_format.shortIndices ? sizeof(unsigned short) : sizeof(unsigned int));
+
+	glGenBuffers(1, &a_data.VBO);
+	glGenBuffers(1, &a_data.IBO);
+
+	glGenVertexArrays(1, &a_data.VAO);
+	glBindVertexArray(a_data.VAO);
+
+	//VBO
+	glBindBuffer(GL_ARRAY_BUFFER, a_data.VBO);
+	glBufferData(GL_ARRAY_BUFFER, a_vertexBytes, a_vertices, GL_STATIC_DRAW);
+
+	//IBO
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, a_data.IBO);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexBytes, a_indices, GL_STATIC_DRAW);
+
+	//set vertex properties, w of the position comes out as 1
+	size_t offset = 0;
+	unsigned int stride = a_format.vertexSize;
+
+	glEnableVertexAttribArray(0);	//pos
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride, (void*)offset);
+	offset += sizeof(float) * 3;
+
+	glEnableVertexAttribArray(1);	//tex coord
+	if (a_format.texCoord == TEXCOORD_FLOAT)
+	{
+		glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, stride, (void*)offset);
+		offset += sizeof(vec2);
+	}
+	else
+	{
+		if (a_format.texCoord == TEXCOORD_HALF)
+			glVertexAttribPointer(1, 2, GL_HALF_FLOAT, GL_FALSE, stride, (void*)offset);
+		else
+			glVertexAttribPointer(1, 2, GL_UNSIGNED_SHORT, GL_TRUE, stride, (void*)offset);
+		offset += sizeof(unsigned int);
+	}
+
+	if (a_format.normals)
+	{
+		glEnableVertexAttribArray(2);	//normal
+		glVertexAttribPointer(2, 4, GL_INT_2_10_10_10_REV, GL_TRUE, stride, (void*)offset);
+	}
+
+	//unbind
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+}
+
+void CompactMesh::optimiseVertexCache(std::vector<unsigned int>& a_indices, unsigned int a_vertexCount)
+{
+	unsigned int triangleCount = (unsigned int)(a_indices.size() / 3);
+	if (triangleCount == 0)
+		return;
+
+	//triangles using each vertex, packed one vertex after another
+	std::vector<unsigned int> remaining(a_vertexCount, 0);
+	for (auto index : a_indices)
+		remaining[index]++;
+
+	std::vector<unsigned int> firstTriangle(a_vertexCount + 1, 0);
+	for (unsigned int v = 0; v < a_vertexCount; v++)
+		firstTriangle[v + 1] = firstTriangle[v] + remaining[v];
+
+	std::vector<unsigned int> vertexTriangles(a_indices.size());
+	std::vector<unsigned int> filled(a_vertexCount, 0);
+	for (unsigned int t = 0; t < triangleCount; t++)
+	{
+		for (unsigned int corner = 0; corner < 3; corner++)
+		{
+			unsigned int v = a_indices[t * 3 + corner];
+			vertexTriangles[firstTriangle[v] + filled[v]++] = t;
+		}
+	}
+
+	std::vector<int> cachePosition(a_vertexCount, -1);
+	std::vector<float> vertexScores(a_vertexCount);
+	for (unsigned int v = 0; v < a_vertexCount; v++)
+		vertexScores[v] = vertexScore(-1, remaining[v]);
+
+	std::vector<float> triangleScores(triangleCount);
+	for (unsigned int t = 0; t < triangleCount; t++)
+	{
+		triangleScores[t] = vertexScores[a_indices[t * 3]] + vertexScores[a_indices[t * 3 + 1]] +
+							vertexScores[a_indices[t * 3 + 2]];
+	}
+
+	std::vector<unsigned char> emitted(triangleCount, 0);
+	std::vector<unsigned int> output;
+	output.reserve(a_indices.size());
+
+	//one extra slot for the triangle's vertices pushing the last ones out
+	unsigned int cache[CACHE_SIZE + 3];
+	unsigned int cacheCount = 0;
+
+	unsigned int best = 0;
+	unsigned int scanStart = 0;
+
+	for (unsigned int emittedCount = 0; emittedCount < triangleCount; emittedCount++)
+	{
+		//nothing in the cache has triangles left, take the best of whatever is left
+		if (best == NOT_CACHED)
+		{
+			float bestScore = -1.0f;
+			while (scanStart < triangleCount && emitted[scanStart])
+				scanStart++;
+
+			for (unsigned int t = scanStart; t < triangleCount; t++)
+			{
+				if (emitted[t] == 0 && triangleScores[t] > bestScore)
+				{
+					bestScore = triangleScores[t];
+					best = t;
+				}
+			}
+		}
+
+		emitted[best] = 1;
+
+		//add the triangle's vertices to the front of the cache, moving the rest back
+		unsigned int newCache[CACHE_SIZE + 3];
+		unsigned int newCount = 0;
+
+		for (unsigned int corner = 0; corner < 3; corner++)
+		{
+			unsigned int v = a_indices[best * 3 + corner];
+			output.push_back(v);
+			newCache[newCount++] = v;
+
+			//take the triangle off the vertex's list
+			unsigned int* triangles = &vertexTriangles[firstTriangle[v]];
+			for (unsigned int i = 0; i < remaining[v]; i++)
+			{
+				if (triangles[i] == best)
+				{
+					triangles[i] = triangles[remaining[v] - 1];
+					break;
+				}
+			}
+			remaining[v]--;
+		}
+
+		for (unsigned int i = 0; i < cacheCount; i++)
+		{
+			unsigned int v = cache[i];
+			if (v != newCache[0] && v != newCache[1] && v != newCache[2])
+				newCache[newCount++] = v;
+		}
+
+		//vertices which fell out of the cache lose their position bonus
+		for (unsigned int i = CACHE_SIZE; i < newCount; i++)
+		{
+			cachePosition[newCache[i]] = -1;
+			vertexScores[newCache[i]] = vertexScore(-1, remaining[newCache[i]]);
+		}
+
+		cacheCount = newCount < CACHE_SIZE ? newCount : CACHE_SIZE;
+		memcpy(cache, newCache, cacheCount * sizeof(unsigned int));
+
+		for (unsigned int i = 0; i < cacheCount; i++)
+		{
+			cachePosition[cache[i]] = i;
+			vertexScores[cache[i]] = vertexScore(i, remaining[cache[i]]);
+		}
+
+		//rescore the triangles around the cache and pick the next one from them
+		float bestScore = -1.0f;
+		best = NOT_CACHED;
+
+		for (unsigned int i = 0; i < cacheCount; i++)
+		{
+			unsigned int v = cache[i];
+			const unsigned int* triangles = &vertexTriangles[firstTriangle[v]];
+
+			for (unsigned int j = 0; j < remaining[v]; j++)
+			{
+				unsigned int t = triangles[j];
+				if (emitted[t])
+					continue;
+
+				triangleScores[t] = vertexScores[a_indices[t * 3]] + vertexScores[a_indices[t * 3 + 1]] +
+									vertexScores[a_indices[t * 3 + 2]];
+
+				if (triangleScores[t] > bestScore)
+				{
+					bestScore = triangleScores[t];
+					best = t;
+				}
+			}
+		}
+	}
+
+	a_indices.swap(output);
+}
@@ -0,0 +1,73 @@
+#ifndef _COMPACTMESH_H_
+#define _COMPACTMESH_H_
+
+#include <vector>
+#include <FBXFile.h>
+
+#include "shader_data_objects.h"
+
+//repacks an FBX mesh into only the attributes the shaders read, in the smallest formats that
+//hold them: float3 position, a 4 byte texture coordinate and optionally a 4 byte normal, instead
+//of the 128 byte FBXVertex. triangles are reordered for the post-transform vertex cache, vertices
+//into the order the triangles first use them, and indices drop to 16 bits when they fit.
+class CompactMesh
+{
+public:
+	enum TexCoordFormat
+	{
+		TEXCOORD_FLOAT,		//8 bytes, exact
+		TEXCOORD_HALF,		//4 bytes, fine for coordinates which tile outside 0-1
+		TEXCOORD_UNORM16,	//4 bytes, more precise in 0-1, falls back to half for meshes which go outside it
+	};
+
+	struct Layout
+	{
+		Layout() : texCoord(TEXCOORD_UNORM16), normals(false) {}
+
+		TexCoordFormat texCoord;
+		bool normals;		//2_10_10_10 signed normalised at location 2
+	};
+
+	//what a built mesh ended up with
+	struct Format
+	{
+		unsigned int vertexSize;
+		TexCoordFormat texCoord;	//after any fallback to half
+		bool normals;
+		bool shortIndices;			//unsigned short when every index fits, otherwise unsigned int
+	};
+
+	CompactMesh();
+	~CompactMesh();
+
+	void build(const std::vector<FBXVertex>& a_vertices, const std::vector<unsigned int>& a_indices, const Layout& a_layout);
+
+	//creates a_data's buffers and vertex array, position at location 0, texture coordinate at 1 and normal at 2
+	void upload(ShaderObjs::OpenGLData& a_data) const;
+
+	//the same from buffers packed earlier, eg. mapped from a MeshCache
+	static void upload(ShaderObjs::OpenGLData& a_data, const Format& a_format, const void* a_vertices, size_t a_vertexBytes,
+					   const void* a_indices, unsigned int a_indexCount);
+
+	const Format& getFormat() const { return m_format; }
+	const unsigned char* getVertexData() const { return m_vertices.data(); }
+	const unsigned char* getIndexData() const { return m_indices.data(); }
+	unsigned int getIndexCount() const { return m_indexCount; }
+
+	unsigned int getVertexSize() const { return m_format.vertexSize; }
+	size_t getVertexBytes() const { return m_vertices.size(); }
+	size_t getIndexBytes() const { return m_indices.size(); }
+
+	//reorders a_indices' triangles so they reuse recently transformed vertices (Forsyth's
+	//linear-speed vertex cache optimisation)
+	static void optimiseVertexCache(std::vector<unsigned int>& a_indices, unsigned int a_vertexCount);
+
+private:
+	std::vector<unsigned char> m_vertices;
+	std::vector<unsigned char> m_indices;
+
+	Format m_format;
+	unsigned int m_indexCount;
+};
+
+#endif // !_COMPACTMESH_H_
@@ -8,6 +8,8 @@
 #include "shader_data_objects.h"
 
 #include "Camera.h"
+#include "CompactMesh.h"
+#include "ResourceRegistry.h"
 
 class PhysicsDemoScene;
 
@@ -17,23 +19,26 @@ public:
 	FBXActor();
 	~FBXActor();
 
-	bool Init(const char* a_filename);
+	//shares a_filename's model through a_registry, loading and uploading it all before returning
+	//if nothing has yet. AssetStreamer does the same spread over a loader thread and frames
+	bool Init(const char* a_filename, ResourceRegistry& a_registry);
 	void createCollisionShapes(PhysicsDemoScene *a_app);
 
-	void Update(float a_dt);
-	void Render(float* a_viewProj);
+	//takes over a reference to a_model, letting go of the one it had
+	void SetModel(ModelResource* a_model);
 
-	void GenerateGLMeshes();
+	//the model is uploaded and drawn for real
+	bool IsReady() const { return m_model != nullptr && m_model->m_ready; }
 
-public:
-	//model file
-	FBXFile* m_file;
+	//drawn through ModelRenderer, batched with every other actor sharing its meshes
+	void Update(float a_dt);
 
-	//model meshes
-	std::vector<ShaderObjs::OpenGLData> m_meshes;
+public:
+	//buffers, textures and program, shared with every other actor drawing the same model
+	ModelResource* m_model;
 
-	//shader program
-	unsigned int m_program;
+	//what the model's vertices are packed into, set before Init
+	CompactMesh::Layout m_vertexLayout;
 
 	//world transform
 	mat4 m_world;
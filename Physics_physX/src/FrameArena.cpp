@@ -0,0 +1,70 @@
+#include "FrameArena.h"
+#include "AllocationCounter.h"
+
+#include <cstdlib>
+
+FrameArena::FrameArena(size_t a_capacity)
+	: m_buffer((char*)malloc(a_capacity)),
+	m_capacity(a_capacity),
+	m_used(0),
+	m_offset(0),
+	m_peak(0)
+{
+	//room for a few spills without growing mid frame
+	m_overflow.reserve(16);
+}
+
+FrameArena::~FrameArena()
+{
+	reset();
+	free(m_buffer);
+}
+
+void* FrameArena::allocate(size_t a_size, size_t a_alignment)
+{
+	//round up to the alignment
+	size_t start = (m_offset + a_alignment - 1) & ~(a_alignment - 1);
+
+	if (start + a_size <= m_capacity)
+	{
+		m_offset = start + a_size;
+		m_used += a_size;
+		if (m_used > m_peak)
+			m_peak = m_used;
+
+		return m_buffer + start;
+	}
+
+	//out of room this frame, spill onto the heap
+	char* block = (char*)malloc(a_size + a_alignment);
+	AddAllocationCount();
+	m_overflow.push_back(block);
+
+	m_used += a_size + a_alignment;
+	if (m_used > m_peak)
+		m_peak = m_used;
+
+	size_t aligned = ((size_t)block + a_alignment - 1) & ~(a_alignment - 1);
+	return (void*)aligned;
+}
+
+void FrameArena::reset()
+{
+	//grow so next frame fits in one block
+	if (m_overflow.empty() == false)
+	{
+		for (auto block : m_overflow)
+		{
+			free(block);
+		}
+		m_overflow.clear();
+
+		free(m_buffer);
+		m_capacity = m_peak + m_peak / 2;
+		m_buffer = (char*)malloc(m_capacity);
+		AddAllocationCount();
+	}
+
+	m_offset = 0;
+	m_used = 0;
+}
@@ -0,0 +1,38 @@
+#ifndef _FRAMEARENA_H_
+#define _FRAMEARENA_H_
+
+#include <cstddef>
+#include <vector>
+
+//linear allocator for scratch memory which only has to live until the end of the frame.
+//everything is freed at once by reset(), if a frame runs out of room the extra comes from
+//the heap and the arena grows to fit on the next reset so the following frames don't.
+class FrameArena
+{
+public:
+	FrameArena(size_t a_capacity = 1024 * 1024);
+	~FrameArena();
+
+	void* allocate(size_t a_size, size_t a_alignment = 16);
+
+	template<typename T>
+	T* allocate(unsigned int a_count) { return (T*)allocate(sizeof(T) * a_count, __alignof(T) > 16 ? __alignof(T) : 16); }
+
+	//free everything allocated this frame
+	void reset();
+
+	size_t getCapacity() const { return m_capacity; }
+	size_t getUsed() const { return m_used; }
+	size_t getPeak() const { return m_peak; }
+
+private:
+	char* m_buffer;
+	size_t m_capacity;
+	size_t m_used;		//includes anything that spilled onto the heap
+	size_t m_offset;	//within m_buffer
+	size_t m_peak;
+
+	std::vector<void*> m_overflow;	//heap blocks used this frame once m_buffer ran out
+};
+
+#endif // !_FRAMEARENA_H_
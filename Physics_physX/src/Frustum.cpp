@@ -0,0 +1,97 @@
+#include "Frustum.h"
+
+#include <xmmintrin.h>
+
+Frustum::Frustum()
+{
+	for (auto& plane : m_planes)
+		plane = vec4(0, 0, 0, 1);	//everything passes until it's set
+}
+
+void Frustum::setFromMatrix(const mat4& a_viewProj)
+{
+	//rows of the matrix, glm is column major
+	vec4 row0(a_viewProj[0][0], a_viewProj[1][0], a_viewProj[2][0], a_viewProj[3][0]);
+	vec4 row1(a_viewProj[0][1], a_viewProj[1][1], a_viewProj[2][1], a_viewProj[3][1]);
+	vec4 row2(a_viewProj[0][2], a_viewProj[1][2], a_viewProj[2][2], a_viewProj[3][2]);
+	vec4 row3(a_viewProj[0][3], a_viewProj[1][3], a_viewProj[2][3], a_viewProj[3][3]);
+
+	m_planes[PLANE_LEFT] = row3 + row0;
+	m_planes[PLANE_RIGHT] = row3 - row0;
+	m_planes[PLANE_BOTTOM] = row3 + row1;
+	m_planes[PLANE_TOP] = row3 - row1;
+	m_planes[PLANE_NEAR] = row3 + row2;
+	m_planes[PLANE_FAR] = row3 - row2;
+
+	//normalise so distances come out in world units
+	for (auto& plane : m_planes)
+		plane /= glm::length(vec3(plane));
+}
+
+bool Frustum::testSphere(const vec3& a_centre, float a_radius) const
+{
+	for (auto& plane : m_planes)
+	{
+		if (glm::dot(vec3(plane), a_centre) + plane.w < -a_radius)
+			return false;
+	}
+
+	return true;
+}
+
+bool Frustum::testAABB(const vec3& a_min, const vec3& a_max) const
+{
+	for (auto& plane : m_planes)
+	{
+		//the corner furthest along the plane's normal
+		vec3 corner(plane.x >= 0 ? a_max.x : a_min.x,
+					plane.y >= 0 ? a_max.y : a_min.y,
+					plane.z >= 0 ? a_max.z : a_min.z);
+
+		if (glm::dot(vec3(plane), corner) + plane.w < 0)
+			return false;
+	}
+
+	return true;
+}
+
+void Frustum::testSpheres(const float* a_x, const float* a_y, const float* a_z, const float* a_radius,
+						  unsigned int a_count, unsigned char* a_visible) const
+{
+	__m128 planeX[PLANE_COUNT], planeY[PLANE_COUNT], planeZ[PLANE_COUNT], planeW[PLANE_COUNT];
+	for (unsigned int p = 0; p < PLANE_COUNT; p++)
+	{
+		planeX[p] = _mm_set1_ps(m_planes[p].x);
+		planeY[p] = _mm_set1_ps(m_planes[p].y);
+		planeZ[p] = _mm_set1_ps(m_planes[p].z);
+		planeW[p] = _mm_set1_ps(m_planes[p].w);
+	}
+
+	unsigned int i = 0;
+	for (; i + 4 <= a_count; i += 4)
+	{
+		__m128 x = _mm_loadu_ps(a_x + i);
+		__m128 y = _mm_loadu_ps(a_y + i);
+		__m128 z = _mm_loadu_ps(a_z + i);
+		__m128 negRadius = _mm_sub_ps(_mm_setzero_ps(), _mm_loadu_ps(a_radius + i));
+
+		//a lane stays set while its sphere is in front of every plane
+		__m128 inside = _mm_cmpeq_ps(x, x);
+		for (unsigned int p = 0; p < PLANE_COUNT; p++)
+		{
+			__m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, planeX[p]), _mm_mul_ps(y, planeY[p])),
+										 _mm_add_ps(_mm_mul_ps(z, planeZ[p]), planeW[p]));
+			inside = _mm_and_ps(inside, _mm_cmpge_ps(distance, negRadius));
+		}
+
+		int mask = _mm_movemask_ps(inside);
+		a_visible[i + 0] = (mask >> 0) & 1;
+		a_visible[i + 1] = (mask >> 1) & 1;
+		a_visible[i + 2] = (mask >> 2) & 1;
+		a_visible[i + 3] = (mask >> 3) & 1;
+	}
+
+	//the last few one at a time
+	for (; i < a_count; i++)
+		a_visible[i] = testSphere(vec3(a_x[i], a_y[i], a_z[i]), a_radius[i]) ? 1 : 0;
+}
@@ -0,0 +1,40 @@
+#ifndef _FRUSTUM_H_
+#define _FRUSTUM_H_
+
+#include "glm_includes.h"
+
+//the six planes of a camera's view volume, normals pointing inwards. single spheres and boxes
+//can be tested on their own, or whole arrays of spheres four at a time with SSE.
+class Frustum
+{
+public:
+	//not NEAR and FAR, windows.h defines those
+	enum Plane
+	{
+		PLANE_LEFT,
+		PLANE_RIGHT,
+		PLANE_BOTTOM,
+		PLANE_TOP,
+		PLANE_NEAR,
+		PLANE_FAR,
+		PLANE_COUNT
+	};
+
+	Frustum();
+
+	//pulls the planes out of a combined projection * view matrix
+	void setFromMatrix(const mat4& a_viewProj);
+
+	bool testSphere(const vec3& a_centre, float a_radius) const;
+	bool testAABB(const vec3& a_min, const vec3& a_max) const;
+
+	//a_visible[i] is set to 1 if sphere i touches the frustum, otherwise 0.
+	//the arrays are separate components so four spheres load at once
+	void testSpheres(const float* a_x, const float* a_y, const float* a_z, const float* a_radius,
+					 unsigned int a_count, unsigned char* a_visible) const;
+
+private:
+	vec4 m_planes[PLANE_COUNT];	//xyz normal, w distance
+};
+
+#endif // !_FRUSTUM_H_
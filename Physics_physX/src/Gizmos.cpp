@@ -1,5 +1,6 @@
 #include "Gizmos.h"
 #include "gl_core_4_4.h"
+#include "Profiler.h"
 
 #define GLM_SWIZZLE
 #include <glm/glm.hpp>
@@ -7,22 +8,21 @@
 
 Gizmos* Gizmos::sm_singleton = nullptr;
 
-Gizmos::Gizmos(unsigned int a_maxLines, unsigned int a_maxTris,
-			   unsigned int a_max2DLines, unsigned int a_max2DTris)
-	: m_maxLines(a_maxLines),
-	m_lineCount(0),
-	m_lines(new GizmoLine[a_maxLines]),
-	m_maxTris(a_maxTris),
+Gizmos::Gizmos(unsigned int a_lines, unsigned int a_tris,
+			   unsigned int a_2DLines, unsigned int a_2DTris, unsigned int a_ceiling)
+	: m_lineCount(0),
+	m_lines(nullptr),
 	m_triCount(0),
-	m_tris(new GizmoTri[a_maxTris]),
+	m_tris(nullptr),
 	m_transparentTriCount(0),
-	m_transparentTris(new GizmoTri[a_maxTris]),
-	m_max2DLines(a_max2DLines),
+	m_transparentTris(nullptr),
 	m_2DlineCount(0),
-	m_2Dlines(new GizmoLine[a_max2DLines]),
-	m_max2DTris(a_max2DTris),
+	m_2Dlines(nullptr),
 	m_2DtriCount(0),
-	m_2Dtris(new GizmoTri[a_max2DTris])
+	m_2Dtris(nullptr),
+	// core in 4.4, otherwise only there with ARB_buffer_storage
+	m_persistent(glBufferStorage != nullptr),
+	m_ceiling(a_ceiling)
 {
 	// create shaders
 	const char* vsSource = "#version 150\n \
@@ -71,95 +71,213 @@ Gizmos::Gizmos(unsigned int a_maxLines, unsigned int a_maxTris,
 	glDeleteShader(fs);
     
     // create VBOs
-	glGenBuffers( 1, &m_lineVBO );
-	glBindBuffer(GL_ARRAY_BUFFER, m_lineVBO);
-	glBufferData(GL_ARRAY_BUFFER, m_maxLines * sizeof(GizmoLine), m_lines, GL_DYNAMIC_DRAW);
-
-	glGenBuffers( 1, &m_triVBO );
-	glBindBuffer(GL_ARRAY_BUFFER, m_triVBO);
-	glBufferData(GL_ARRAY_BUFFER, m_maxTris * sizeof(GizmoTri), m_tris, GL_DYNAMIC_DRAW);
+	createStream(m_lineStream, glm::min(a_lines, m_ceiling), sizeof(GizmoLine), 2);
+	createStream(m_triStream, glm::min(a_tris, m_ceiling), sizeof(GizmoTri), 3);
+	createStream(m_transparentTriStream, glm::min(a_tris, m_ceiling), sizeof(GizmoTri), 3);
+	createStream(m_2DlineStream, glm::min(a_2DLines, m_ceiling), sizeof(GizmoLine), 2);
+	createStream(m_2DtriStream, glm::min(a_2DTris, m_ceiling), sizeof(GizmoTri), 3);
+
+	m_lines = (GizmoLine*)beginStream(m_lineStream);
+	m_tris = (GizmoTri*)beginStream(m_triStream);
+	m_transparentTris = (GizmoTri*)beginStream(m_transparentTriStream);
+	m_2Dlines = (GizmoLine*)beginStream(m_2DlineStream);
+	m_2Dtris = (GizmoTri*)beginStream(m_2DtriStream);
+}
 
-	glGenBuffers( 1, &m_transparentTriVBO );
-	glBindBuffer(GL_ARRAY_BUFFER, m_transparentTriVBO);
-	glBufferData(GL_ARRAY_BUFFER, m_maxTris * sizeof(GizmoTri), m_transparentTris, GL_DYNAMIC_DRAW);
+Gizmos::~Gizmos()
+{
+	destroyStream(m_lineStream);
+	destroyStream(m_triStream);
+	destroyStream(m_transparentTriStream);
+	destroyStream(m_2DlineStream);
+	destroyStream(m_2DtriStream);
+	glDeleteProgram(m_shader);
+}
 
-	glGenBuffers( 1, &m_2DlineVBO );
-	glBindBuffer(GL_ARRAY_BUFFER, m_2DlineVBO);
-	glBufferData(GL_ARRAY_BUFFER, m_max2DLines * sizeof(GizmoLine), m_2Dlines, GL_DYNAMIC_DRAW);
+void Gizmos::createStream(GizmoStream& a_stream, unsigned int a_capacity, unsigned int a_primitiveSize, unsigned int a_primitiveVerts)
+{
+	a_stream.capacity = a_capacity;
+	a_stream.primitiveSize = a_primitiveSize;
+	a_stream.primitiveVerts = a_primitiveVerts;
+	a_stream.frame = 0;
+	a_stream.mapped = nullptr;
+	a_stream.cpuCopy = nullptr;
+	for (auto& fence : a_stream.fences)
+		fence = nullptr;
+
+	a_stream.dropped = 0;
+	a_stream.peak = 0;
+	a_stream.lastFrame.submitted = 0;
+	a_stream.lastFrame.dropped = 0;
+	a_stream.lastFrame.peak = 0;
+	a_stream.lastFrame.capacity = a_capacity;
+
+	glGenBuffers(1, &a_stream.vbo);
+	glBindBuffer(GL_ARRAY_BUFFER, a_stream.vbo);
+
+	if (m_persistent)
+	{
+		// one region per frame in flight, mapped for the life of the buffer
+		GLsizeiptr size = (GLsizeiptr)a_capacity * a_primitiveSize * GizmoStreamFrames;
+		GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
 
-	glGenBuffers( 1, &m_2DtriVBO );
-	glBindBuffer(GL_ARRAY_BUFFER, m_2DtriVBO);
-	glBufferData(GL_ARRAY_BUFFER, m_max2DTris * sizeof(GizmoTri), m_2Dtris, GL_DYNAMIC_DRAW);
+		glBufferStorage(GL_ARRAY_BUFFER, size, nullptr, flags);
+		a_stream.mapped = (char*)glMapBufferRange(GL_ARRAY_BUFFER, 0, size, flags);
+	}
+	else
+	{
+		glBufferData(GL_ARRAY_BUFFER, a_capacity * a_primitiveSize, nullptr, GL_STREAM_DRAW);
+		a_stream.cpuCopy = new char[a_capacity * a_primitiveSize];
+	}
 
-	glGenVertexArrays(1, &m_lineVAO);
-	glBindVertexArray(m_lineVAO);
-	glBindBuffer(GL_ARRAY_BUFFER, m_lineVBO);
+	glGenVertexArrays(1, &a_stream.vao);
+	glBindVertexArray(a_stream.vao);
 	glEnableVertexAttribArray(0);
 	glEnableVertexAttribArray(1);
 	glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, sizeof(GizmoVertex), 0);
 	glVertexAttribPointer(1, 4, GL_FLOAT, GL_TRUE, sizeof(GizmoVertex), ((char*)0) + 16);
 
-	glGenVertexArrays(1, &m_triVAO);
-	glBindVertexArray(m_triVAO);
-	glBindBuffer(GL_ARRAY_BUFFER, m_triVBO);
-	glEnableVertexAttribArray(0);
-	glEnableVertexAttribArray(1);
-	glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, sizeof(GizmoVertex), 0);
-	glVertexAttribPointer(1, 4, GL_FLOAT, GL_TRUE, sizeof(GizmoVertex), ((char*)0) + 16);
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
 
-	glGenVertexArrays(1, &m_transparentTriVAO);
-	glBindVertexArray(m_transparentTriVAO);
-	glBindBuffer(GL_ARRAY_BUFFER, m_transparentTriVBO);
-	glEnableVertexAttribArray(0);
-	glEnableVertexAttribArray(1);
-	glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, sizeof(GizmoVertex), 0);
-	glVertexAttribPointer(1, 4, GL_FLOAT, GL_TRUE, sizeof(GizmoVertex), ((char*)0) + 16);
+void Gizmos::destroyStream(GizmoStream& a_stream)
+{
+	for (auto& fence : a_stream.fences)
+	{
+		if (fence != nullptr)
+			glDeleteSync((GLsync)fence);
+		fence = nullptr;
+	}
 
-	glGenVertexArrays(1, &m_2DlineVAO);
-	glBindVertexArray(m_2DlineVAO);
-	glBindBuffer(GL_ARRAY_BUFFER, m_2DlineVBO);
-	glEnableVertexAttribArray(0);
-	glEnableVertexAttribArray(1);
-	glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, sizeof(GizmoVertex), 0);
-	glVertexAttribPointer(1, 4, GL_FLOAT, GL_TRUE, sizeof(GizmoVertex), ((char*)0) + 16);
+	if (a_stream.mapped != nullptr)
+	{
+		glBindBuffer(GL_ARRAY_BUFFER, a_stream.vbo);
+		glUnmapBuffer(GL_ARRAY_BUFFER);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+	}
 
-	glGenVertexArrays(1, &m_2DtriVAO);
-	glBindVertexArray(m_2DtriVAO);
-	glBindBuffer(GL_ARRAY_BUFFER, m_2DtriVBO);
-	glEnableVertexAttribArray(0);
-	glEnableVertexAttribArray(1);
-	glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, sizeof(GizmoVertex), 0);
-	glVertexAttribPointer(1, 4, GL_FLOAT, GL_TRUE, sizeof(GizmoVertex), ((char*)0) + 16);
+	delete[] a_stream.cpuCopy;
+	glDeleteBuffers(1, &a_stream.vbo);
+	glDeleteVertexArrays(1, &a_stream.vao);
+}
 
-	glBindVertexArray(0);
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
+void* Gizmos::beginStream(GizmoStream& a_stream)
+{
+	if (a_stream.mapped == nullptr)
+		return a_stream.cpuCopy;
+
+	a_stream.frame = (a_stream.frame + 1) % GizmoStreamFrames;
+
+	// make sure the GPU has finished drawing the last time this region was used
+	GLsync fence = (GLsync)a_stream.fences[a_stream.frame];
+	if (fence != nullptr)
+	{
+		GLenum result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+		while (result == GL_TIMEOUT_EXPIRED)
+			result = glClientWaitSync(fence, 0, 1000000);
+
+		glDeleteSync(fence);
+		a_stream.fences[a_stream.frame] = nullptr;
+	}
+
+	return a_stream.mapped + a_stream.frame * a_stream.capacity * a_stream.primitiveSize;
 }
 
-Gizmos::~Gizmos()
+void Gizmos::drawStream(GizmoStream& a_stream, unsigned int a_mode, unsigned int a_count)
 {
-	delete[] m_lines;
-	delete[] m_tris;
-	delete[] m_transparentTris;
-	glDeleteBuffers( 1, &m_lineVBO );
-	glDeleteBuffers( 1, &m_triVBO );
-	glDeleteBuffers( 1, &m_transparentTriVBO );
-	glDeleteVertexArrays( 1, &m_lineVAO );
-	glDeleteVertexArrays( 1, &m_triVAO );
-	glDeleteVertexArrays( 1, &m_transparentTriVAO );
-	delete[] m_2Dlines;
-	delete[] m_2Dtris;
-	glDeleteBuffers( 1, &m_2DlineVBO );
-	glDeleteBuffers( 1, &m_2DtriVBO );
-	glDeleteVertexArrays( 1, &m_2DlineVAO );
-	glDeleteVertexArrays( 1, &m_2DtriVAO );
-	glDeleteProgram(m_shader);
+	unsigned int first = 0;
+
+	glBindBuffer(GL_ARRAY_BUFFER, a_stream.vbo);
+
+	if (a_stream.mapped != nullptr)
+	{
+		// already in place, just draw from this frame's region
+		first = a_stream.frame * a_stream.capacity * a_stream.primitiveVerts;
+	}
+	else
+	{
+		// orphan the old storage so we don't wait on the previous draw
+		glBufferData(GL_ARRAY_BUFFER, a_stream.capacity * a_stream.primitiveSize, nullptr, GL_STREAM_DRAW);
+		glBufferSubData(GL_ARRAY_BUFFER, 0, a_count * a_stream.primitiveSize, a_stream.cpuCopy);
+	}
+
+	glBindVertexArray(a_stream.vao);
+	glDrawArrays(a_mode, first, a_count * a_stream.primitiveVerts);
+
+	if (a_stream.mapped != nullptr)
+	{
+		if (a_stream.fences[a_stream.frame] != nullptr)
+			glDeleteSync((GLsync)a_stream.fences[a_stream.frame]);
+		a_stream.fences[a_stream.frame] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	}
+}
+
+bool Gizmos::reserveStream(GizmoStream& a_stream, unsigned int a_count, void** a_data)
+{
+	if (a_count < a_stream.capacity)
+		return true;
+
+	if (a_stream.capacity >= sm_singleton->m_ceiling)
+	{
+		if (a_stream.dropped == 0 && a_stream.lastFrame.dropped == 0)
+			printf("Warning: Gizmo list is at its ceiling of %u, primitives are being dropped\n", sm_singleton->m_ceiling);
+
+		a_stream.dropped++;
+		return false;
+	}
+
+	// double in size and carry over what has been added this frame
+	GizmoStream grown;
+	sm_singleton->createStream(grown, glm::min(a_stream.capacity * 2, sm_singleton->m_ceiling), a_stream.primitiveSize, a_stream.primitiveVerts);
+
+	void* data = beginStream(grown);
+
+	if (a_stream.mapped != nullptr)
+	{
+		// the mapping is write only, so copy what's there on the GPU rather than reading it back
+		GLintptr oldOffset = (GLintptr)a_stream.frame * a_stream.capacity * a_stream.primitiveSize;
+		GLintptr newOffset = (GLintptr)grown.frame * grown.capacity * grown.primitiveSize;
+
+		glBindBuffer(GL_COPY_READ_BUFFER, a_stream.vbo);
+		glBindBuffer(GL_COPY_WRITE_BUFFER, grown.vbo);
+		glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, oldOffset, newOffset, (GLsizeiptr)a_count * a_stream.primitiveSize);
+		glBindBuffer(GL_COPY_READ_BUFFER, 0);
+		glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+	}
+	else
+		memcpy(data, *a_data, a_count * a_stream.primitiveSize);
+
+	grown.dropped = a_stream.dropped;
+	grown.peak = a_stream.peak;
+	grown.lastFrame = a_stream.lastFrame;
+
+	// the GPU keeps the old buffer alive until it has finished drawing from it
+	destroyStream(a_stream);
+	a_stream = grown;
+
+	*a_data = data;
+	return true;
+}
+
+void Gizmos::endStreamFrame(GizmoStream& a_stream, unsigned int a_count)
+{
+	a_stream.peak = glm::max(a_stream.peak, a_count);
+
+	a_stream.lastFrame.submitted = a_count + a_stream.dropped;
+	a_stream.lastFrame.dropped = a_stream.dropped;
+	a_stream.lastFrame.peak = a_stream.peak;
+	a_stream.lastFrame.capacity = a_stream.capacity;
+
+	a_stream.dropped = 0;
 }
 
-void Gizmos::create(unsigned int a_maxLines /* = 0xffff */, unsigned int a_maxTris /* = 0xffff */,
-					unsigned int a_max2DLines /* = 0xff */, unsigned int a_max2DTris /* = 0xff */)
+void Gizmos::create(unsigned int a_lines /* = 0x1000 */, unsigned int a_tris /* = 0x1000 */,
+					unsigned int a_2DLines /* = 0xff */, unsigned int a_2DTris /* = 0xff */,
+					unsigned int a_ceiling /* = 0x100000 */)
 {
 	if (sm_singleton == nullptr)
-		sm_singleton = new Gizmos(a_maxLines,a_maxTris,a_max2DLines,a_max2DTris);
+		sm_singleton = new Gizmos(a_lines,a_tris,a_2DLines,a_2DTris,a_ceiling);
 }
 
 void Gizmos::destroy()
@@ -170,11 +288,43 @@ void Gizmos::destroy()
 
 void Gizmos::clear()
 {
+	endStreamFrame(sm_singleton->m_lineStream, sm_singleton->m_lineCount);
+	endStreamFrame(sm_singleton->m_triStream, sm_singleton->m_triCount);
+	endStreamFrame(sm_singleton->m_transparentTriStream, sm_singleton->m_transparentTriCount);
+	endStreamFrame(sm_singleton->m_2DlineStream, sm_singleton->m_2DlineCount);
+	endStreamFrame(sm_singleton->m_2DtriStream, sm_singleton->m_2DtriCount);
+
 	sm_singleton->m_lineCount = 0;
 	sm_singleton->m_triCount = 0;
 	sm_singleton->m_transparentTriCount = 0;
 	sm_singleton->m_2DlineCount = 0;
 	sm_singleton->m_2DtriCount = 0;
+	sm_singleton->m_frameArena.reset();
+
+	// gizmos for the new frame go in the next part of each ring
+	sm_singleton->m_lines = (GizmoLine*)beginStream(sm_singleton->m_lineStream);
+	sm_singleton->m_tris = (GizmoTri*)beginStream(sm_singleton->m_triStream);
+	sm_singleton->m_transparentTris = (GizmoTri*)beginStream(sm_singleton->m_transparentTriStream);
+	sm_singleton->m_2Dlines = (GizmoLine*)beginStream(sm_singleton->m_2DlineStream);
+	sm_singleton->m_2Dtris = (GizmoTri*)beginStream(sm_singleton->m_2DtriStream);
+}
+
+Gizmos::Stats Gizmos::getStats(List a_list)
+{
+	GizmoStream* streams[LIST_COUNT] = {
+		&sm_singleton->m_lineStream,
+		&sm_singleton->m_triStream,
+		&sm_singleton->m_transparentTriStream,
+		&sm_singleton->m_2DlineStream,
+		&sm_singleton->m_2DtriStream,
+	};
+
+	return streams[a_list]->lastFrame;
+}
+
+FrameArena& Gizmos::getFrameArena()
+{
+	return sm_singleton->m_frameArena;
 }
 
 // Adds 3 unit-length lines (red,green,blue) representing the 3 axis of a transform, 
@@ -584,7 +734,7 @@ void Gizmos::addSphereFilled(const glm::vec3& a_center, float a_radius, int a_ro
 	float latitiudinalRange = (a_latMax - a_latMin) * DEG2RAD;
 	float longitudinalRange = (a_longMax - a_longMin) * DEG2RAD;
 	// for each row of the mesh
-	glm::vec3* v4Array = new glm::vec3[a_rows*a_columns + a_columns];
+	glm::vec3* v4Array = sm_singleton->m_frameArena.allocate<glm::vec3>(a_rows*a_columns + a_columns);
 
 	for (int row = 0; row <= a_rows; ++row)
 	{
@@ -633,7 +783,6 @@ void Gizmos::addSphereFilled(const glm::vec3& a_center, float a_radius, int a_ro
 		addTri( a_center + v4Array[iNextFace+a_columns], a_center + v4Array[face+a_columns], a_center + v4Array[face], a_fillColour);		
 	}
 
-	delete[] v4Array;	
 }
 
 void Gizmos::addSphere(const glm::vec3& a_center, float a_radius, int a_rows, int a_columns, const glm::vec4& a_fillColour,
@@ -651,7 +800,7 @@ void Gizmos::addSphere(const glm::vec3& a_center, float a_radius, int a_rows, in
     float latitiudinalRange = (a_latMax - a_latMin) * DEG2RAD;
     float longitudinalRange = (a_longMax - a_longMin) * DEG2RAD;
     // for each row of the mesh
-    glm::vec3* v4Array = new glm::vec3[a_rows*a_columns + a_columns];
+    glm::vec3* v4Array = sm_singleton->m_frameArena.allocate<glm::vec3>(a_rows*a_columns + a_columns);
 
     for (int row = 0; row <= a_rows; ++row)
     {
@@ -696,8 +845,6 @@ void Gizmos::addSphere(const glm::vec3& a_center, float a_radius, int a_rows, in
         }
         addLine(a_center + v4Array[iNextFace + a_columns], a_center + v4Array[face + a_columns], glm::vec4(1.f, 1.f, 1.f, 1.f), glm::vec4(1.f, 1.f, 1.f, 1.f));
      }
-
-    delete[] v4Array;
 }
 void Gizmos::addHermiteSpline(const glm::vec3& a_start, const glm::vec3& a_end,
 	const glm::vec3& a_tangentStart, const glm::vec3& a_tangentEnd, unsigned int a_segments, const glm::vec4& a_colour)
@@ -731,7 +878,7 @@ void Gizmos::addLine(const glm::vec3& a_rv0,  const glm::vec3& a_rv1, const glm:
 void Gizmos::addLine(const glm::vec3& a_rv0, const glm::vec3& a_rv1, const glm::vec4& a_colour0, const glm::vec4& a_colour1)
 {
 	if (sm_singleton != nullptr &&
-		sm_singleton->m_lineCount < sm_singleton->m_maxLines)
+		reserveStream(sm_singleton->m_lineStream, sm_singleton->m_lineCount, (void**)&sm_singleton->m_lines))
 	{
 		sm_singleton->m_lines[sm_singleton->m_lineCount].v0.x = a_rv0.x;
 		sm_singleton->m_lines[sm_singleton->m_lineCount].v0.y = a_rv0.y;
@@ -761,7 +908,7 @@ void Gizmos::addTri(const glm::vec3& a_rv0, const glm::vec3& a_rv1, const glm::v
 	{
 		if (a_colour.w == 1)
 		{
-			if (sm_singleton->m_triCount < sm_singleton->m_maxTris)
+			if (reserveStream(sm_singleton->m_triStream, sm_singleton->m_triCount, (void**)&sm_singleton->m_tris))
 			{
 				sm_singleton->m_tris[sm_singleton->m_triCount].v0.x = a_rv0.x;
 				sm_singleton->m_tris[sm_singleton->m_triCount].v0.y = a_rv0.y;
@@ -794,7 +941,7 @@ void Gizmos::addTri(const glm::vec3& a_rv0, const glm::vec3& a_rv1, const glm::v
 		}
 		else
 		{
-			if (sm_singleton->m_transparentTriCount < sm_singleton->m_maxTris)
+			if (reserveStream(sm_singleton->m_transparentTriStream, sm_singleton->m_transparentTriCount, (void**)&sm_singleton->m_transparentTris))
 			{
 				sm_singleton->m_transparentTris[sm_singleton->m_transparentTriCount].v0.x = a_rv0.x;
 				sm_singleton->m_transparentTris[sm_singleton->m_transparentTriCount].v0.y = a_rv0.y;
@@ -911,7 +1058,7 @@ void Gizmos::add2DLine(const glm::vec2& a_rv0,  const glm::vec2& a_rv1, const gl
 void Gizmos::add2DLine(const glm::vec2& a_rv0, const glm::vec2& a_rv1, const glm::vec4& a_colour0, const glm::vec4& a_colour1)
 {
 	if (sm_singleton != nullptr &&
-		sm_singleton->m_2DlineCount < sm_singleton->m_max2DLines)
+		reserveStream(sm_singleton->m_2DlineStream, sm_singleton->m_2DlineCount, (void**)&sm_singleton->m_2Dlines))
 	{
 		sm_singleton->m_2Dlines[sm_singleton->m_2DlineCount].v0.x = a_rv0.x;
 		sm_singleton->m_2Dlines[sm_singleton->m_2DlineCount].v0.y = a_rv0.y;
@@ -938,7 +1085,7 @@ void Gizmos::add2DTri(const glm::vec2& a_rv0, const glm::vec2& a_rv1, const glm:
 {
 	if (sm_singleton != nullptr)
 	{
-		if (sm_singleton->m_2DtriCount < sm_singleton->m_max2DTris)
+		if (reserveStream(sm_singleton->m_2DtriStream, sm_singleton->m_2DtriCount, (void**)&sm_singleton->m_2Dtris))
 		{
 			sm_singleton->m_2Dtris[sm_singleton->m_2DtriCount].v0.x = a_rv0.x;
 			sm_singleton->m_2Dtris[sm_singleton->m_2DtriCount].v0.y = a_rv0.y;
@@ -977,6 +1124,8 @@ void Gizmos::draw(const glm::mat4& a_projection, const glm::mat4& a_view)
 
 void Gizmos::draw(const glm::mat4& a_projectionView)
 {
+	PROFILE_ZONE("Gizmos::draw");
+
 	if ( sm_singleton != nullptr && (sm_singleton->m_lineCount > 0 || sm_singleton->m_triCount > 0 || sm_singleton->m_transparentTriCount > 0))
 	{
 		int shader = 0;
@@ -989,20 +1138,12 @@ void Gizmos::draw(const glm::mat4& a_projectionView)
 
 		if (sm_singleton->m_lineCount > 0)
 		{
-			glBindBuffer(GL_ARRAY_BUFFER, sm_singleton->m_lineVBO);
-			glBufferSubData(GL_ARRAY_BUFFER, 0, sm_singleton->m_lineCount * sizeof(GizmoLine), sm_singleton->m_lines);
-
-			glBindVertexArray(sm_singleton->m_lineVAO);
-			glDrawArrays(GL_LINES, 0, sm_singleton->m_lineCount * 2);
+			drawStream(sm_singleton->m_lineStream, GL_LINES, sm_singleton->m_lineCount);
 		}
 
 		if (sm_singleton->m_triCount > 0)
 		{
-			glBindBuffer(GL_ARRAY_BUFFER, sm_singleton->m_triVBO);
-			glBufferSubData(GL_ARRAY_BUFFER, 0, sm_singleton->m_triCount * sizeof(GizmoTri), sm_singleton->m_tris);
-
-			glBindVertexArray(sm_singleton->m_triVAO);
-			glDrawArrays(GL_TRIANGLES, 0, sm_singleton->m_triCount * 3);
+			drawStream(sm_singleton->m_triStream, GL_TRIANGLES, sm_singleton->m_triCount);
 		}
 
 		if (sm_singleton->m_transparentTriCount > 0)
@@ -1021,11 +1162,7 @@ void Gizmos::draw(const glm::mat4& a_projectionView)
 			glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 			glDepthMask(GL_FALSE);
 
-			glBindBuffer(GL_ARRAY_BUFFER, sm_singleton->m_transparentTriVBO);
-			glBufferSubData(GL_ARRAY_BUFFER, 0, sm_singleton->m_transparentTriCount * sizeof(GizmoTri), sm_singleton->m_transparentTris);
-
-			glBindVertexArray(sm_singleton->m_transparentTriVAO);
-			glDrawArrays(GL_TRIANGLES, 0, sm_singleton->m_transparentTriCount * 3);
+			drawStream(sm_singleton->m_transparentTriStream, GL_TRIANGLES, sm_singleton->m_transparentTriCount);
 
 			// reset state
 			glDepthMask(depthMask);
@@ -1040,6 +1177,8 @@ void Gizmos::draw(const glm::mat4& a_projectionView)
 
 void Gizmos::draw2D(const glm::mat4& a_projection)
 {
+	PROFILE_ZONE("Gizmos::draw2D");
+
 	if ( sm_singleton != nullptr && (sm_singleton->m_2DlineCount > 0 || sm_singleton->m_2DtriCount > 0))
 	{
 		int shader = 0;
@@ -1052,11 +1191,7 @@ void Gizmos::draw2D(const glm::mat4& a_projection)
 
 		if (sm_singleton->m_2DlineCount > 0)
 		{
-			glBindBuffer(GL_ARRAY_BUFFER, sm_singleton->m_2DlineVBO);
-			glBufferSubData(GL_ARRAY_BUFFER, 0, sm_singleton->m_2DlineCount * sizeof(GizmoLine), sm_singleton->m_2Dlines);
-
-			glBindVertexArray(sm_singleton->m_2DlineVAO);
-			glDrawArrays(GL_LINES, 0, sm_singleton->m_2DlineCount * 2);
+			drawStream(sm_singleton->m_2DlineStream, GL_LINES, sm_singleton->m_2DlineCount);
 		}
 
 		if (sm_singleton->m_2DtriCount > 0)
@@ -1077,11 +1212,7 @@ void Gizmos::draw2D(const glm::mat4& a_projection)
 
 			glDepthMask(GL_FALSE);
 
-			glBindBuffer(GL_ARRAY_BUFFER, sm_singleton->m_2DtriVBO);
-			glBufferSubData(GL_ARRAY_BUFFER, 0, sm_singleton->m_2DtriCount * sizeof(GizmoTri), sm_singleton->m_2Dtris);
-
-			glBindVertexArray(sm_singleton->m_2DtriVAO);
-			glDrawArrays(GL_TRIANGLES, 0, sm_singleton->m_2DtriCount * 3);
+			drawStream(sm_singleton->m_2DtriStream, GL_TRIANGLES, sm_singleton->m_2DtriCount);
 
 			glDepthMask(depthMask);
 
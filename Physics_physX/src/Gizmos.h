@@ -2,17 +2,45 @@
 
 #include <glm/fwd.hpp>
 
+#include "FrameArena.h"
+
 class Gizmos
 {
 public:
 
-	static void		create(unsigned int a_maxLines = 0xffff, unsigned int a_maxTris = 0xffff,
-						   unsigned int a_max2DLines = 0xff, unsigned int a_max2DTris = 0xff);
+	// the sizes are where each list starts, they grow as needed up to a_ceiling primitives
+	static void		create(unsigned int a_lines = 0x1000, unsigned int a_tris = 0x1000,
+						   unsigned int a_2DLines = 0xff, unsigned int a_2DTris = 0xff,
+						   unsigned int a_ceiling = 0x100000);
 	static void		destroy();
 
-	// removes all Gizmos
+	enum List
+	{
+		LINES,
+		TRIS,
+		TRANSPARENT_TRIS,
+		LINES_2D,
+		TRIS_2D,
+		LIST_COUNT
+	};
+
+	// primitive counts for one of the lists, covering the last frame that was cleared
+	struct Stats
+	{
+		unsigned int	submitted;		// everything added, including dropped primitives
+		unsigned int	dropped;		// didn't fit under the ceiling
+		unsigned int	peak;			// most held in a single frame so far
+		unsigned int	capacity;		// current size of the list
+	};
+
+	static Stats	getStats(List a_list);
+
+	// removes all Gizmos and frees this frame's scratch memory
 	static void		clear();
 
+	// scratch memory which lives until the next clear()
+	static FrameArena&	getFrameArena();
+
 	// draws current Gizmo buffers, either using a combined (projection * view) matrix, or separate matrices
 	static void		draw(const glm::mat4& a_projectionView);
 	static void		draw(const glm::mat4& a_projection, const glm::mat4& a_view);
@@ -92,8 +120,8 @@ public:
 	
 private:
 
-	Gizmos(unsigned int a_maxLines, unsigned int a_maxTris,
-		   unsigned int a_max2DLines, unsigned int a_max2DTris);
+	Gizmos(unsigned int a_lines, unsigned int a_tris,
+		   unsigned int a_2DLines, unsigned int a_2DTris, unsigned int a_ceiling);
 	~Gizmos();
 
 	struct GizmoVertex
@@ -115,45 +143,79 @@ private:
 		GizmoVertex v2;
 	};
 
+	// a ring of GizmoStreamFrames vertex buffers which gizmos are written straight into, so the
+	// frame being written never touches a buffer the GPU may still be drawing from. when
+	// persistent mapping isn't available it falls back to a CPU copy and orphaning the buffer.
+	enum { GizmoStreamFrames = 3 };
+
+	struct GizmoStream
+	{
+		unsigned int	vao;
+		unsigned int	vbo;
+		unsigned int	capacity;			// primitives per frame
+		unsigned int	primitiveSize;		// bytes per primitive
+		unsigned int	primitiveVerts;
+		unsigned int	frame;				// region of the ring currently being written
+		char*			mapped;				// whole ring, null when orphaning
+		char*			cpuCopy;			// used instead of mapped when orphaning
+		void*			fences[GizmoStreamFrames];
+
+		unsigned int	dropped;			// this frame
+		unsigned int	peak;
+		Stats			lastFrame;
+	};
+
+	void			createStream(GizmoStream& a_stream, unsigned int a_capacity, unsigned int a_primitiveSize, unsigned int a_primitiveVerts);
+	static void		destroyStream(GizmoStream& a_stream);
+
+	// moves on to the next region of the ring, waiting for the GPU if it's still using it
+	static void*	beginStream(GizmoStream& a_stream);
+	static void		drawStream(GizmoStream& a_stream, unsigned int a_mode, unsigned int a_count);
+
+	// makes sure there is room for one more primitive, growing the stream if it's full.
+	// returns false and counts the primitive as dropped once the ceiling is reached
+	static bool		reserveStream(GizmoStream& a_stream, unsigned int a_count, void** a_data);
+	static void		endStreamFrame(GizmoStream& a_stream, unsigned int a_count);
+
 	unsigned int	m_shader;
 
+	// per-frame scratch memory
+	FrameArena		m_frameArena;
+
 	// line data
-	unsigned int	m_maxLines;
 	unsigned int	m_lineCount;
-	GizmoLine*		m_lines;
+	GizmoLine*		m_lines;		// points into m_lineStream
 
-	unsigned int	m_lineVAO;
-	unsigned int 	m_lineVBO;
+	GizmoStream		m_lineStream;
 
 	// triangle data
-	unsigned int	m_maxTris;
 	unsigned int	m_triCount;
 	GizmoTri*		m_tris;
 
-	unsigned int	m_triVAO;
-	unsigned int 	m_triVBO;
+	GizmoStream		m_triStream;
 	
 	unsigned int	m_transparentTriCount;
 	GizmoTri*		m_transparentTris;
 
-	unsigned int	m_transparentTriVAO;
-	unsigned int 	m_transparentTriVBO;
+	GizmoStream		m_transparentTriStream;
 	
 	// 2D line data
-	unsigned int	m_max2DLines;
 	unsigned int	m_2DlineCount;
 	GizmoLine*		m_2Dlines;
 
-	unsigned int	m_2DlineVAO;
-	unsigned int 	m_2DlineVBO;
+	GizmoStream		m_2DlineStream;
 
 	// 2D triangle data
-	unsigned int	m_max2DTris;
 	unsigned int	m_2DtriCount;
 	GizmoTri*		m_2Dtris;
 
-	unsigned int	m_2DtriVAO;
-	unsigned int 	m_2DtriVBO;
+	GizmoStream		m_2DtriStream;
+
+	// persistent mapping is in use, rather than orphaning
+	bool			m_persistent;
+
+	// no list grows past this many primitives
+	unsigned int	m_ceiling;
 
 	static Gizmos*	sm_singleton;
 };
\ No newline at end of file
@@ -0,0 +1,422 @@
+#include "MeshCache.h"
+
+#include <cstdio>
+#include <cstring>
+#include <cfloat>
+#include <string>
+#include <unordered_map>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+	const char BakeMagic[8] = { 'P', 'X', 'B', 'A', 'K', 'E', 0, 0 };
+
+	//sections start on this so the mapped buffers are aligned for upload
+	const size_t SECTION_ALIGN = 16;
+
+	size_t align(size_t a_offset)
+	{
+		return (a_offset + SECTION_ALIGN - 1) & ~(SECTION_ALIGN - 1);
+	}
+
+	void writeAt(FILE* a_file, size_t a_offset, const void* a_data, size_t a_bytes)
+	{
+		fseek(a_file, (long)a_offset, SEEK_SET);
+		fwrite(a_data, 1, a_bytes, a_file);
+	}
+}
+
+MeshCache::MeshCache() : m_data(nullptr), m_size(0), m_file(nullptr), m_mapping(nullptr) {}
+
+MeshCache::~MeshCache()
+{
+	close();
+}
+
+unsigned int MeshCache::packLayout(const CompactMesh::Layout& a_layout)
+{
+	return (unsigned int)a_layout.texCoord | (a_layout.normals ? 1 << 8 : 0);
+}
+
+CompactMesh::Format MeshCache::getFormat(const Mesh& a_mesh)
+{
+	CompactMesh::Format format;
+	format.vertexSize = a_mesh.vertexSize;
+	format.texCoord = (CompactMesh::TexCoordFormat)a_mesh.texCoordFormat;
+	format.normals = (a_mesh.flags & MESH_NORMALS) != 0;
+	format.shortIndices = (a_mesh.flags & MESH_SHORT_INDICES) != 0;
+	return format;
+}
+
+const MeshCache::Mesh& MeshCache::getMesh(unsigned int a_index) const
+{
+	return ((const Mesh*)(m_data + sizeof(Header)))[a_index];
+}
+
+const MeshCache::Texture& MeshCache::getTexture(unsigned int a_index) const
+{
+	const unsigned char* textures = m_data + sizeof(Header) + sizeof(Mesh) * getHeader().meshCount;
+	return ((const Texture*)textures)[a_index];
+}
+
+unsigned long long MeshCache::hashFile(const char* a_filename)
+{
+	FILE* file = fopen(a_filename, "rb");
+	if (file == nullptr)
+		return 0;
+
+	unsigned long long hash = 14695981039346656037ull;
+
+	static const size_t chunkSize = 64 * 1024;
+	std::vector<unsigned char> chunk(chunkSize);
+
+	size_t read;
+	while ((read = fread(chunk.data(), 1, chunkSize, file)) > 0)
+	{
+		for (size_t i = 0; i < read; i++)
+		{
+			hash ^= chunk[i];
+			hash *= 1099511628211ull;
+		}
+	}
+
+	fclose(file);
+
+	//0 means no source
+	return hash != 0 ? hash : 1;
+}
+
+bool MeshCache::open(const char* a_bakeFile, unsigned long long a_sourceHash, const CompactMesh::Layout& a_layout)
+{
+	close();
+
+#ifdef _WIN32
+	HANDLE file = CreateFileA(a_bakeFile, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+		return false;
+
+	LARGE_INTEGER size;
+	GetFileSizeEx(file, &size);
+
+	HANDLE mapping = size.QuadPart > 0 ? CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr) : nullptr;
+	if (mapping == nullptr)
+	{
+		CloseHandle(file);
+		return false;
+	}
+
+	m_data = (const unsigned char*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	if (m_data == nullptr)
+	{
+		CloseHandle(mapping);
+		CloseHandle(file);
+		return false;
+	}
+
+	m_size = (size_t)size.QuadPart;
+	m_file = file;
+	m_mapping = mapping;
+#else
+	int file = ::open(a_bakeFile, O_RDONLY);
+	if (file < 0)
+		return false;
+
+	struct stat info;
+	fstat(file, &info);
+
+	void* data = info.st_size > 0 ? mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, file, 0) : MAP_FAILED;
+	::close(file);
+
+	if (data == MAP_FAILED)
+		return false;
+
+	m_data = (const unsigned char*)data;
+	m_size = (size_t)info.st_size;
+#endif
+
+	//stale or from another build, the caller rebakes
+	const Header& header = getHeader();
+	bool valid = m_size >= sizeof(Header) &&
+				 memcmp(header.magic, BakeMagic, sizeof(BakeMagic)) == 0 &&
+				 header.version == VERSION &&
+				 header.layout == packLayout(a_layout) &&
+				 (a_sourceHash == 0 || header.sourceHash == a_sourceHash) &&
+				 m_size >= sizeof(Header) + sizeof(Mesh) * (unsigned long long)header.meshCount + sizeof(Texture) * (unsigned long long)header.textureCount;
+
+	//everything the tables point at has to be inside the file and describe what the uploads will
+	//read from it, a bake which doesn't is treated as stale and rebuilt rather than handed to GL
+	for (unsigned int i = 0; valid && i < header.meshCount; i++)
+		valid = validateMesh(getMesh(i), header.textureCount);
+
+	for (unsigned int i = 0; valid && i < header.textureCount; i++)
+	{
+		const Texture& texture = getTexture(i);
+		unsigned long long pixelBytes = (unsigned long long)texture.width * texture.height * texture.channels;
+
+		valid = texture.channels >= 1 && texture.channels <= 4 &&
+				texture.width > 0 && texture.height > 0 &&
+				texture.bytes == pixelBytes &&
+				inFile(texture.offset, texture.bytes);
+	}
+
+	if (valid == false)
+	{
+		close();
+		return false;
+	}
+
+	return true;
+}
+
+bool MeshCache::inFile(unsigned long long a_offset, unsigned long long a_bytes) const
+{
+	//written so neither side can overflow
+	return a_offset <= m_size && a_bytes <= m_size - a_offset;
+}
+
+bool MeshCache::validateMesh(const Mesh& a_mesh, unsigned int a_textureCount) const
+{
+	bool shortIndices = (a_mesh.flags & MESH_SHORT_INDICES) != 0;
+
+	//the stride CompactMesh packs this format with, which is what the attributes will be set up for
+	unsigned int texCoordSize = a_mesh.texCoordFormat == CompactMesh::TEXCOORD_FLOAT ? sizeof(float) * 2 : sizeof(unsigned short) * 2;
+	unsigned int vertexSize = sizeof(float) * 3 + texCoordSize + ((a_mesh.flags & MESH_NORMALS) ? sizeof(unsigned int) : 0);
+	unsigned long long indexBytes = (unsigned long long)a_mesh.indexCount * (shortIndices ? sizeof(unsigned short) : sizeof(unsigned int));
+
+	if (a_mesh.texCoordFormat > CompactMesh::TEXCOORD_UNORM16 ||
+		a_mesh.diffuseTexture < -1 || a_mesh.diffuseTexture >= (int)a_textureCount ||
+		a_mesh.vertexSize != vertexSize ||
+		a_mesh.vertexBytes % a_mesh.vertexSize != 0 ||
+		inFile(a_mesh.vertexOffset, a_mesh.vertexBytes) == false ||
+		inFile(a_mesh.indexOffset, indexBytes) == false)
+		return false;
+
+	//every index has to land on a vertex, the GPU doesn't check
+	unsigned long long vertexCount = a_mesh.vertexBytes / a_mesh.vertexSize;
+	const void* indices = getData(a_mesh.indexOffset);
+
+	for (unsigned int i = 0; i < a_mesh.indexCount; i++)
+	{
+		unsigned int index = shortIndices ? ((const unsigned short*)indices)[i] : ((const unsigned int*)indices)[i];
+		if (index >= vertexCount)
+			return false;
+	}
+
+	return true;
+}
+
+bool MeshCache::load(const char* a_fbxFile, const CompactMesh::Layout& a_layout)
+{
+	//the baked copy sits next to the FBX, it is only loaded through the FBX SDK when the bake
+	//is missing, from an older version or layout, or the FBX has changed since
+	std::string bakeFile = std::string(a_fbxFile) + ".bake";
+	unsigned long long sourceHash = hashFile(a_fbxFile);
+
+	if (open(bakeFile.c_str(), sourceHash, a_layout))
+		return true;
+
+	if (sourceHash == 0)
+	{
+		printf("Error: Failed to open %s or a bake of it\n", a_fbxFile);
+		return false;
+	}
+
+	return bake(a_fbxFile, bakeFile.c_str(), sourceHash, a_layout) && open(bakeFile.c_str(), sourceHash, a_layout);
+}
+
+void MeshCache::prefetch() const
+{
+	const size_t pageSize = 4096;
+
+	volatile unsigned char sum = 0;
+	for (size_t offset = 0; offset < m_size; offset += pageSize)
+		sum += m_data[offset];
+}
+
+void MeshCache::close()
+{
+	if (m_data == nullptr)
+		return;
+
+#ifdef _WIN32
+	UnmapViewOfFile(m_data);
+	CloseHandle((HANDLE)m_mapping);
+	CloseHandle((HANDLE)m_file);
+#else
+	munmap((void*)m_data, m_size);
+#endif
+
+	m_data = nullptr;
+	m_size = 0;
+	m_file = nullptr;
+	m_mapping = nullptr;
+}
+
+bool MeshCache::bake(const char* a_fbxFile, const char* a_bakeFile, unsigned long long a_sourceHash, const CompactMesh::Layout& a_layout)
+{
+	FBXFile fbx;
+	if (fbx.load(a_fbxFile) == false)
+	{
+		printf("Error: Failed to load %s\n", a_fbxFile);
+		return false;
+	}
+
+	//written next to the bake and renamed over it at the end, so a failed bake never leaves half a file
+	std::string tempFile = std::string(a_bakeFile) + ".tmp";
+	FILE* file = fopen(tempFile.c_str(), "wb");
+	if (file == nullptr)
+	{
+		printf("Error: Failed to open %s for writing\n", tempFile.c_str());
+		return false;
+	}
+
+	unsigned int meshCount = fbx.getMeshCount();
+
+	//textures used as a diffuse map, each once
+	std::vector<FBXTexture*> textures;
+	std::unordered_map<FBXTexture*, int> textureIndex;
+	std::vector<int> meshTextures(meshCount, -1);
+
+	for (unsigned int i = 0; i < meshCount; i++)
+	{
+		FBXMaterial* material = fbx.getMeshByIndex(i)->m_material;
+		FBXTexture* texture = material != nullptr ? material->textures[FBXMaterial::DiffuseTexture] : nullptr;
+
+		if (texture == nullptr || texture->data == nullptr || texture->format < 1 || texture->format > 4)
+			continue;
+
+		auto found = textureIndex.find(texture);
+		if (found == textureIndex.end())
+		{
+			found = textureIndex.insert(std::make_pair(texture, (int)textures.size())).first;
+			textures.push_back(texture);
+		}
+
+		meshTextures[i] = found->second;
+	}
+
+	Header header;
+	memcpy(header.magic, BakeMagic, sizeof(BakeMagic));
+	header.version = VERSION;
+	header.layout = packLayout(a_layout);
+	header.sourceHash = a_sourceHash;
+	header.meshCount = meshCount;
+	header.textureCount = (unsigned int)textures.size();
+
+	vec3 modelMin(FLT_MAX), modelMax(-FLT_MAX);
+
+	std::vector<Mesh> meshes(meshCount);
+	size_t sourceBytes = 0;
+	size_t packedBytes = 0;
+	size_t offset = align(sizeof(Header) + sizeof(Mesh) * meshCount + sizeof(Texture) * textures.size());
+
+	for (unsigned int i = 0; i < meshCount; i++)
+	{
+		FBXMeshNode* source = fbx.getMeshByIndex(i);
+
+		CompactMesh packed;
+		packed.build(source->m_vertices, source->m_indices, a_layout);
+
+		const CompactMesh::Format& format = packed.getFormat();
+
+		Mesh& mesh = meshes[i];
+		mesh.vertexSize = format.vertexSize;
+		mesh.texCoordFormat = format.texCoord;
+		mesh.flags = (format.normals ? MESH_NORMALS : 0) | (format.shortIndices ? MESH_SHORT_INDICES : 0);
+		mesh.diffuseTexture = meshTextures[i];
+		mesh.indexCount = packed.getIndexCount();
+
+		mesh.vertexOffset = offset;
+		mesh.vertexBytes = packed.getVertexBytes();
+		writeAt(file, offset, packed.getVertexData(), packed.getVertexBytes());
+		offset = align(offset + packed.getVertexBytes());
+
+		mesh.indexOffset = offset;
+		writeAt(file, offset, packed.getIndexData(), packed.getIndexBytes());
+		offset = align(offset + packed.getIndexBytes());
+
+		sourceBytes += sizeof(FBXVertex) * source->m_vertices.size() + sizeof(unsigned int) * source->m_indices.size();
+		packedBytes += packed.getVertexBytes() + packed.getIndexBytes();
+
+		//culling box
+		vec3 meshMin(0), meshMax(0);
+		if (source->m_vertices.empty() == false)
+		{
+			meshMin = vec3(FLT_MAX);
+			meshMax = vec3(-FLT_MAX);
+
+			for (auto& vertex : source->m_vertices)
+			{
+				meshMin = glm::min(meshMin, vec3(vertex.position));
+				meshMax = glm::max(meshMax, vec3(vertex.position));
+			}
+
+			modelMin = glm::min(modelMin, meshMin);
+			modelMax = glm::max(modelMax, meshMax);
+		}
+
+		memcpy(mesh.boundsMin, &meshMin, sizeof(mesh.boundsMin));
+		memcpy(mesh.boundsMax, &meshMax, sizeof(mesh.boundsMax));
+	}
+
+	if (meshCount == 0)
+		modelMin = modelMax = vec3(0);
+
+	memcpy(header.boundsMin, &modelMin, sizeof(header.boundsMin));
+	memcpy(header.boundsMax, &modelMax, sizeof(header.boundsMax));
+
+	//decoded pixels, so a mapped bake never touches an image loader
+	std::vector<Texture> textureTable(textures.size());
+	for (unsigned int i = 0; i < textures.size(); i++)
+	{
+		Texture& texture = textureTable[i];
+		texture.width = textures[i]->width;
+		texture.height = textures[i]->height;
+		texture.channels = textures[i]->format;
+		texture.pad = 0;
+		texture.offset = offset;
+		texture.bytes = (unsigned long long)texture.width * texture.height * texture.channels;
+
+		writeAt(file, offset, textures[i]->data, (size_t)texture.bytes);
+		offset = align(offset + (size_t)texture.bytes);
+	}
+
+	//tables last, now the offsets are known
+	writeAt(file, 0, &header, sizeof(header));
+	if (meshCount > 0)
+		writeAt(file, sizeof(Header), meshes.data(), sizeof(Mesh) * meshCount);
+	if (textureTable.empty() == false)
+		writeAt(file, sizeof(Header) + sizeof(Mesh) * meshCount, textureTable.data(), sizeof(Texture) * textureTable.size());
+
+	bool written = ferror(file) == 0;
+	fclose(file);
+
+	if (written == false)
+	{
+		printf("Error: Failed to write %s\n", tempFile.c_str());
+		remove(tempFile.c_str());
+		return false;
+	}
+
+	//rename won't replace an existing file everywhere
+	remove(a_bakeFile);
+	if (rename(tempFile.c_str(), a_bakeFile) != 0)
+	{
+		printf("Error: Failed to replace %s\n", a_bakeFile);
+		return false;
+	}
+
+	printf("Baked %s into %s, %u KB of meshes packed into %u KB, %u KB in all\n", a_fbxFile, a_bakeFile,
+		(unsigned int)(sourceBytes / 1024), (unsigned int)(packedBytes / 1024), (unsigned int)(offset / 1024));
+	return true;
+}
@@ -0,0 +1,106 @@
+#ifndef _MESHCACHE_H_
+#define _MESHCACHE_H_
+
+#include "CompactMesh.h"
+
+//a model baked into one file that can be mapped and uploaded as it is: the CompactMesh buffers
+//of every mesh, the decoded textures its materials use and a model space box per mesh for
+//culling. the header records the format version, the vertex layout and a hash of the source FBX,
+//so changing any of them causes a rebake.
+class MeshCache
+{
+public:
+	static const unsigned int VERSION = 1;
+
+	//everything below sits in the file as it is, offsets are from the start of the file
+	struct Header
+	{
+		char magic[8];
+		unsigned int version;
+		unsigned int layout;			//packLayout of the CompactMesh::Layout it was baked with
+		unsigned long long sourceHash;
+		unsigned int meshCount;
+		unsigned int textureCount;
+		float boundsMin[3];				//of the whole model
+		float boundsMax[3];
+	};
+
+	struct Mesh
+	{
+		unsigned long long vertexOffset;
+		unsigned long long vertexBytes;
+		unsigned long long indexOffset;
+		unsigned int indexCount;
+		unsigned int vertexSize;
+		unsigned int texCoordFormat;	//CompactMesh::TexCoordFormat
+		unsigned int flags;				//MESH_NORMALS, MESH_SHORT_INDICES
+		int diffuseTexture;				//index into the textures, -1 for none
+		float boundsMin[3];				//model space box, for culling
+		float boundsMax[3];
+	};
+
+	struct Texture
+	{
+		unsigned long long offset;
+		unsigned long long bytes;
+		unsigned int width;
+		unsigned int height;
+		unsigned int channels;			//1 to 4
+		unsigned int pad;
+	};
+
+	enum MeshFlags
+	{
+		MESH_NORMALS = 1 << 0,
+		MESH_SHORT_INDICES = 1 << 1,
+	};
+
+	MeshCache();
+	~MeshCache();
+
+	//maps a_bakeFile if it was baked with a_layout from a source with a_sourceHash, a_sourceHash
+	//of 0 accepts any source so a bake can ship without its FBX
+	bool open(const char* a_bakeFile, unsigned long long a_sourceHash, const CompactMesh::Layout& a_layout);
+	void close();
+
+	bool isOpen() const { return m_data != nullptr; }
+
+	//opens a_fbxFile's bake, baking it first if it is missing or stale
+	bool load(const char* a_fbxFile, const CompactMesh::Layout& a_layout);
+
+	//reads a byte from every page so the file is in memory before anything is uploaded from it,
+	//lets a loading thread take the disk reads instead of whoever uploads
+	void prefetch() const;
+
+	//loads a_fbxFile through the FBX SDK, packs it and writes a_bakeFile
+	static bool bake(const char* a_fbxFile, const char* a_bakeFile, unsigned long long a_sourceHash, const CompactMesh::Layout& a_layout);
+
+	//FNV-1a of the whole file, 0 if it can't be read
+	static unsigned long long hashFile(const char* a_filename);
+
+	const Header& getHeader() const { return *(const Header*)m_data; }
+	const Mesh& getMesh(unsigned int a_index) const;
+	const Texture& getTexture(unsigned int a_index) const;
+
+	//a_offset into the mapped file
+	const void* getData(unsigned long long a_offset) const { return m_data + a_offset; }
+
+	static CompactMesh::Format getFormat(const Mesh& a_mesh);
+
+private:
+	static unsigned int packLayout(const CompactMesh::Layout& a_layout);
+
+	//a_bytes from a_offset lie inside the mapping
+	bool inFile(unsigned long long a_offset, unsigned long long a_bytes) const;
+
+	//a_mesh's buffers are inside the file, its sizes agree and its indices stay on its vertices
+	bool validateMesh(const Mesh& a_mesh, unsigned int a_textureCount) const;
+
+	const unsigned char* m_data;
+	size_t m_size;
+
+	void* m_file;		//platform handles for the mapping
+	void* m_mapping;
+};
+
+#endif // !_MESHCACHE_H_
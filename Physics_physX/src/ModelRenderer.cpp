@@ -0,0 +1,196 @@
+#include "ModelRenderer.h"
+
+#include "gl_core_4_4.h"
+#include "Profiler.h"
+#include "Gizmos.h"
+#include "FBXActor.h"
+
+#include <algorithm>
+
+//the instance matrix takes four attributes after position, tex coord and normal
+static const unsigned int WORLD_ATTRIBUTE = 3;
+
+ModelRenderer::ModelRenderer() : m_instanceVBO(0), m_instanceCapacity(0), m_drawCalls(0) {}
+ModelRenderer::~ModelRenderer() {}
+
+void ModelRenderer::create(unsigned int a_instanceCapacity)
+{
+	m_instanceCapacity = a_instanceCapacity;
+	m_items.reserve(m_instanceCapacity);
+	m_worlds.reserve(m_instanceCapacity);
+	m_instances.reserve(m_instanceCapacity);
+
+	glGenBuffers(1, &m_instanceVBO);
+	glBindBuffer(GL_ARRAY_BUFFER, m_instanceVBO);
+	glBufferData(GL_ARRAY_BUFFER, m_instanceCapacity * sizeof(mat4), nullptr, GL_STREAM_DRAW);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void ModelRenderer::destroy()
+{
+	glDeleteBuffers(1, &m_instanceVBO);
+	m_instanceVBO = 0;
+
+	clear();
+}
+
+void ModelRenderer::clear()
+{
+	m_items.clear();
+	m_worlds.clear();
+}
+
+//world space box around a model space box moved by a_world
+static void transformBounds(const mat4& a_world, const vec3& a_min, const vec3& a_max, vec3& a_worldMin, vec3& a_worldMax)
+{
+	vec3 centre = vec3(a_world * vec4((a_min + a_max) * 0.5f, 1));
+	vec3 extents = (a_max - a_min) * 0.5f;
+
+	//each world axis takes the absolute contribution of every rotated local axis
+	vec3 worldExtents = glm::abs(vec3(a_world[0])) * extents.x +
+						glm::abs(vec3(a_world[1])) * extents.y +
+						glm::abs(vec3(a_world[2])) * extents.z;
+
+	a_worldMin = centre - worldExtents;
+	a_worldMax = centre + worldExtents;
+}
+
+void ModelRenderer::add(const FBXActor& a_actor, const Frustum* a_frustum)
+{
+	const mat4& world = a_actor.m_world;
+	const ModelResource* model = a_actor.m_model;
+
+	//still streaming in, show where it will be
+	if (a_actor.IsReady() == false)
+	{
+		bool boundsKnown = model != nullptr && model->m_boundsKnown;
+		vec3 centre = boundsKnown ? (model->m_boundsMin + model->m_boundsMax) * 0.5f : vec3(0);
+		vec3 extents = boundsKnown ? (model->m_boundsMax - model->m_boundsMin) * 0.5f : vec3(0.5f);
+
+		mat4 rotation = mat4(glm::mat3(world));
+		Gizmos::addAABB(vec3(world * vec4(centre, 1)), extents, vec4(1, 1, 1, 0.5f), &rotation);
+		return;
+	}
+
+	vec3 worldMin, worldMax;
+
+	//whole model off screen
+	if (a_frustum != nullptr && model->m_meshes.empty() == false)
+	{
+		transformBounds(world, model->m_boundsMin, model->m_boundsMax, worldMin, worldMax);
+		if (a_frustum->testAABB(worldMin, worldMax) == false)
+			return;
+	}
+
+	unsigned int worldIndex = (unsigned int)m_worlds.size();
+	bool anyVisible = false;
+
+	for (unsigned int i = 0; i < model->m_meshes.size(); i++)
+	{
+		if (a_frustum != nullptr)
+		{
+			transformBounds(world, model->m_meshMin[i], model->m_meshMax[i], worldMin, worldMax);
+			if (a_frustum->testAABB(worldMin, worldMax) == false)
+				continue;
+		}
+
+		Item item;
+		item.program = model->m_program;
+		item.texture = model->m_meshTextures[i];
+		item.VAO = model->m_meshes[i].VAO;
+		item.indexCount = model->m_meshes[i].IndexCount;
+		item.indexType = model->m_meshes[i].IndexType;
+		item.world = worldIndex;
+		m_items.push_back(item);
+
+		anyVisible = true;
+	}
+
+	if (anyVisible)
+		m_worlds.push_back(world);
+}
+
+void ModelRenderer::draw(const mat4& a_projectionView)
+{
+	PROFILE_ZONE("ModelRenderer::draw");
+
+	m_drawCalls = 0;
+
+	if (m_items.empty())
+		return;
+
+	//neighbours now share as much state as they can
+	std::sort(m_items.begin(), m_items.end());
+
+	//matrices in the same order, so each run of equal items reads a contiguous range
+	m_instances.resize(m_items.size());
+	for (unsigned int i = 0; i < m_items.size(); i++)
+		m_instances[i] = m_worlds[m_items[i].world];
+
+	unsigned int count = (unsigned int)m_instances.size();
+
+	glBindBuffer(GL_ARRAY_BUFFER, m_instanceVBO);
+
+	//grow the instance buffer if needed, otherwise orphan it so we don't wait on last frame's draws
+	if (count > m_instanceCapacity)
+	{
+		while (m_instanceCapacity < count)
+			m_instanceCapacity *= 2;
+	}
+	glBufferData(GL_ARRAY_BUFFER, m_instanceCapacity * sizeof(mat4), nullptr, GL_STREAM_DRAW);
+	glBufferSubData(GL_ARRAY_BUFFER, 0, count * sizeof(mat4), m_instances.data());
+
+	int shader = 0;
+	glGetIntegerv(GL_CURRENT_PROGRAM, &shader);
+
+	unsigned int program = 0;
+	unsigned int texture = 0;
+
+	glActiveTexture(GL_TEXTURE0);
+
+	for (unsigned int first = 0; first < count;)
+	{
+		const Item& item = m_items[first];
+
+		//everything after it drawn the same way
+		unsigned int last = first + 1;
+		while (last < count && (item < m_items[last]) == false)
+			last++;
+
+		//only bind what changed since the last run
+		if (item.program != program || m_drawCalls == 0)
+		{
+			program = item.program;
+			glUseProgram(program);
+
+			glUniformMatrix4fv(glGetUniformLocation(program, "projection_view"), 1, GL_FALSE, (float*)&a_projectionView);
+			glUniform1i(glGetUniformLocation(program, "diffuse"), 0);
+		}
+
+		if (item.texture != texture || m_drawCalls == 0)
+		{
+			texture = item.texture;
+			glBindTexture(GL_TEXTURE_2D, texture);
+		}
+
+		//the mesh's VAO reads its matrices from this run's part of the instance buffer
+		glBindVertexArray(item.VAO);
+		for (unsigned int i = 0; i < 4; i++)
+		{
+			glEnableVertexAttribArray(WORLD_ATTRIBUTE + i);
+			glVertexAttribPointer(WORLD_ATTRIBUTE + i, 4, GL_FLOAT, GL_FALSE, sizeof(mat4), ((char*)0) + first * sizeof(mat4) + sizeof(vec4) * i);
+			glVertexAttribDivisor(WORLD_ATTRIBUTE + i, 1);
+		}
+
+		glDrawElementsInstanced(GL_TRIANGLES, item.indexCount, item.indexType, nullptr, last - first);
+		m_drawCalls++;
+
+		first = last;
+	}
+
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	glUseProgram(shader);
+}
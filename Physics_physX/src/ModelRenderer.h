@@ -0,0 +1,67 @@
+#ifndef _MODELRENDERER_H_
+#define _MODELRENDERER_H_
+
+#include <vector>
+
+#include "glm_includes.h"
+
+#include "Frustum.h"
+
+class FBXActor;
+
+//draws FBXActors batched. each frame the visible meshes of every actor are gathered with their
+//world matrices, sorted by program, then texture, then VAO, and every run sharing all three is
+//one instanced draw reading its matrices from a single instance buffer. draw calls and state
+//changes then follow the number of distinct meshes rather than the number of actors.
+class ModelRenderer
+{
+public:
+	ModelRenderer();
+	~ModelRenderer();
+
+	void create(unsigned int a_instanceCapacity = 256);
+	void destroy();
+
+	//forgets last frame's instances, keeps the memory
+	void clear();
+
+	//queues a_actor's meshes which touch a_frustum, until its model is ready a gizmo box goes instead
+	void add(const FBXActor& a_actor, const Frustum* a_frustum = nullptr);
+
+	void draw(const mat4& a_projectionView);
+
+	unsigned int getInstanceCount() const { return (unsigned int)m_items.size(); }
+	unsigned int getDrawCallCount() const { return m_drawCalls; }
+
+private:
+	//one mesh of one actor, sorts by what has to be bound to draw it
+	struct Item
+	{
+		unsigned int program;
+		unsigned int texture;
+		unsigned int VAO;
+		unsigned int indexCount;
+		unsigned int indexType;
+		unsigned int world;		//index into m_worlds
+
+		bool operator<(const Item& a_other) const
+		{
+			if (program != a_other.program)
+				return program < a_other.program;
+			if (texture != a_other.texture)
+				return texture < a_other.texture;
+			return VAO < a_other.VAO;
+		}
+	};
+
+	std::vector<Item> m_items;
+	std::vector<mat4> m_worlds;		//one per actor added
+	std::vector<mat4> m_instances;	//m_worlds in draw order, what goes in the instance buffer
+
+	unsigned int m_instanceVBO;
+	unsigned int m_instanceCapacity;	//size of m_instanceVBO in matrices
+
+	unsigned int m_drawCalls;
+};
+
+#endif // !_MODELRENDERER_H_
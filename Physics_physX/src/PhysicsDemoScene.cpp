@@ -3,6 +3,15 @@
 #include "gl_core_4_4.h"
 #include <GLFW/glfw3.h>
 #include "Gizmos.h"
+#include "AllocationCounter.h"
+#include "Profiler.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cfloat>
+#include <chrono>
+#include <cstdio>
+#include <string>
 
 #include "glm/gtc/quaternion.hpp"
 #include "glm/gtc/matrix_transform.hpp"
@@ -21,19 +30,64 @@ public:
 	virtual ~myAllocator() {}
 	virtual void* allocate(size_t size, const char* typeName, const char* filename, int line)
 	{
-		void* pointer = _aligned_malloc(size, 16);
-		return pointer;
+		AddAllocationCount();
+
+		//keep the size in front of the block so deallocate can count the bytes back off
+		char* block = (char*)_aligned_malloc(size + 16, 16);
+		if (block == nullptr)
+			return nullptr;
+
+		*(size_t*)block = size;
+		AddAllocatedBytes(size);
+
+		return block + 16;
 	}
 
 	virtual void deallocate(void* ptr)
 	{
-		_aligned_free(ptr);
+		if (ptr == nullptr)
+			return;
+
+		char* block = (char*)ptr - 16;
+		RemoveAllocatedBytes(*(size_t*)block);
+
+		_aligned_free(block);
 	}
 
 private:
 
 };
 
+//hands PhysX tasks to our task pool
+class myCpuDispatcher : public PxCpuDispatcher
+{
+public:
+	myCpuDispatcher(TaskPool* a_pool) : m_pool(a_pool) {}
+	virtual ~myCpuDispatcher() {}
+
+	virtual void submitTask(PxBaseTask& task)
+	{
+		m_pool->submit(&myCpuDispatcher::runTask, &task);
+	}
+
+	virtual PxU32 getWorkerCount() const
+	{
+		return m_pool->getWorkerCount();
+	}
+
+private:
+	static void runTask(void* a_data, unsigned int a_begin, unsigned int a_end)
+	{
+		PxBaseTask* task = (PxBaseTask*)a_data;
+
+		PROFILE_ZONE(task->getName());
+		task->run();
+		task->release();
+	}
+
+	TaskPool* m_pool;
+};
+
 class MyControllerHitReport : public PxUserControllerHitReport
 {
 public:
@@ -46,12 +100,10 @@ public:
 
 	virtual void onObstacleHit(const PxControllerObstacleHit &hit) { };	//Called when current controller hits a user defined obstacle
 
-	MyControllerHitReport() : PxUserControllerHitReport() { };
-
-	PxVec3 getPlayerContactNormal(){ return _playerContactNormal; }
-	void clearPlayerContactNormal(){ _playerContactNormal = PxVec3(0, 0, 0); }
+	MyControllerHitReport(SimulationEvents* a_events) : PxUserControllerHitReport(), m_events(a_events) { };
 
-	PxVec3 _playerContactNormal;
+private:
+	SimulationEvents* m_events;
 };
 
 void MyControllerHitReport::onShapeHit(const PxControllerShapeHit &hit)
@@ -60,19 +112,136 @@ void MyControllerHitReport::onShapeHit(const PxControllerShapeHit &hit)
 	//get the actor from the shape we hit
 	PxRigidActor* actor = hit.shape->getActor();
 
-	//get the normal of the thing we hit and store it so the player controller can respond correctly
-	_playerContactNormal = hit.worldNormal;
-
 	//try to cast to a dynamic actor
 	PxRigidDynamic* myActor = actor->is<PxRigidDynamic>();
 	if (myActor != nullptr)
 	{
-		//this is where we can apply forces to things we hit
+		//pushed in DemoEventHandler::onControllerHit once the move is over
+		m_events->pushControllerHit(hit);
 	}
 }
 
+//gameplay reactions to simulation events, called after each fetch
+class DemoEventHandler : public SimulationEventHandler
+{
+public:
+	DemoEventHandler(PhysicsDemoScene* a_scene) : m_scene(a_scene), m_nextImpact(0), m_frame(0)
+	{
+		for (auto& impact : m_impacts)
+			impact.frame = 0;
+	}
+
+	//the player shoves dynamic actors it walks into
+	virtual void onControllerHit(const ControllerHitEvent& a_event)
+	{
+		const float pushImpulse = 20.0f;
+
+		PxRigidDynamic* actor = a_event.actor->is<PxRigidDynamic>();
+		if (actor == nullptr || (actor->getRigidDynamicFlags() & PxRigidDynamicFlag::eKINEMATIC))
+			return;
+
+		PxVec3 direction(a_event.direction.x, 0, a_event.direction.z);
+		if (direction.normalize() > 0)
+			PxRigidBodyExt::addForceAtPos(*actor, direction * pushImpulse, a_event.point, PxForceMode::eIMPULSE);
+	}
+
+	//hard hits leave a mark for a moment
+	virtual void onContact(const ContactEvent& a_event)
+	{
+		const float markImpulse = 10.0f;
+
+		if (a_event.impulse < markImpulse)
+			return;
+
+		Impact& impact = m_impacts[m_nextImpact];
+		impact.point = a_event.point;
+		impact.frame = m_frame + 1;
+		m_nextImpact = (m_nextImpact + 1) % IMPACT_COUNT;
+	}
+
+	//anything which leaves the world is taken out of the scene
+	virtual void onOutOfBounds(const OutOfBoundsEvent& a_event)
+	{
+		m_scene->despawn(a_event.actor);
+	}
+
+	void addGizmos(const Frustum& a_frustum)
+	{
+		const unsigned int lifetime = 30;
+
+		m_frame++;
+
+		for (auto& impact : m_impacts)
+		{
+			if (impact.frame == 0 || m_frame - impact.frame >= lifetime)
+				continue;
+
+			float size = 0.3f * (1.0f - (float)(m_frame - impact.frame) / lifetime);
+			vec3 point(impact.point.x, impact.point.y, impact.point.z);
+
+			if (a_frustum.testSphere(point, size * 1.75f))
+				Gizmos::addAABBFilled(point, vec3(size), vec4(1, 0.8f, 0, 1));
+		}
+	}
+
+private:
+	struct Impact
+	{
+		PxVec3 point;
+		unsigned int frame;	//frame it happened + 1, 0 for unused
+	};
+
+	PhysicsDemoScene* m_scene;
+
+	static const unsigned int IMPACT_COUNT = 32;
+	Impact m_impacts[IMPACT_COUNT];
+	unsigned int m_nextImpact;
+	unsigned int m_frame;
+};
+
 
 bool PhysicsDemoScene::startup()
+{
+	//headless runs never open a window or touch GL
+	if (m_headless == false && setupGraphics() == false)
+		return false;
+
+	//profiling
+	if (m_profile || m_traceFile != nullptr)
+	{
+		Profiler::create();
+		Profiler::setThreadName("Main");
+		Profiler::setEnabled(true);
+	}
+
+	if (m_statsFile != nullptr)
+		m_simStats.openLog(m_statsFile);
+
+	if (m_showStats && m_headless == false)
+		SimulationStats::printLegend();
+
+	//one loader thread, and at most 2ms or 8MB of uploads a frame. headless runs load in place
+	m_assets.create(&m_resources, m_headless ? 0 : 1, 2.0f, 8 << 20);
+
+	//setup PhysX
+	setupPhysX();
+	setupVisualDebugger();
+
+	//projectiles
+	m_projectilePool.create(this, m_maxProjectiles, 0.4f, 100);
+	m_projectilePool.m_killVolume = m_worldBounds;
+
+	//tutorials
+	//setupTutorial();
+	setupPlayerController();
+
+
+	if (m_headless == false)
+		glfwSetTime(0.0);
+	return true;
+}
+
+bool PhysicsDemoScene::setupGraphics()
 {
 	if (Application::startup() == false)
 		return false;
@@ -82,6 +251,8 @@ bool PhysicsDemoScene::startup()
 
 	//init Gizmos
 	Gizmos::create();
+	m_primitives.create();
+	m_modelRenderer.create();
 
 	//get screen width and height
 	int width, height;
@@ -97,34 +268,123 @@ bool PhysicsDemoScene::startup()
 	//setup 2D projection
 	projection2D = glm::ortho(-m_screen_size.x / 2.0f, m_screen_size.x / 2.0f, -m_screen_size.y / 2.0f, m_screen_size.y / 2.0f);
 
-	//setup PhysX
-	setupPhysX();
-	setupVisualDebugger();
-
-	//tutorials
-	//setupTutorial();
-	setupPlayerController();
-
-
-	glfwSetTime(0.0);
 	return true;
 }
 
 void PhysicsDemoScene::shutdown()
 {
+	//finish any step still running
+	fetchPhysX();
+
+	//nothing can be streaming into the models once they're gone
+	m_assets.destroy();
+
+	m_queries.destroy();
+	gCharacterManager->release();
+	delete myHitReport;
 	g_PhysicsScene->release();
+	delete m_eventHandler;
+	m_eventHandler = nullptr;
+
+	//their actors' userData pointed at these
+	for (auto model : m_models)
+		delete model;
+	m_models.clear();
+	m_model = nullptr;
+
+	//the last actors have let go of their models, this only catches leaks
+	m_resources.destroy();
+	PxCloseExtensions();
+
+	//hand over whatever the SDK still has buffered before it goes
+	if (m_bufferedProfiler != nullptr)
+	{
+		m_bufferedProfiler->flushEvents();
+		m_bufferedProfiler->removeBufferedProfilerCallback(m_profileCapture);
+		m_profileCapture.close();
+	}
+
 	g_Physics->release();
+
+	if (m_bufferedProfiler != nullptr)
+		m_bufferedProfiler->release();
+	m_bufferedProfiler = nullptr;
+
 	g_PhysicsFoundation->release();
 
+	//stop the workers once nothing can hand them PhysX tasks
+	delete g_CpuDispatcher;
+	m_taskPool.shutdown();
+
+	//GPU queries have to go before the context does
+	if (m_traceFile != nullptr)
+		Profiler::writeTrace(m_traceFile);
+	if (Profiler::isEnabled())
+		Profiler::printSummary();
+	Profiler::destroy();
+
+	m_simStats.closeLog();
+
+	if (m_headless)
+		return;
+
+	m_primitives.destroy();
+	m_modelRenderer.destroy();
 	Gizmos::destroy();
 	Application::shutdown();
 }
 
+void PhysicsDemoScene::runHeadless(unsigned int a_steps)
+{
+	typedef std::chrono::high_resolution_clock Clock;
+
+	double totalTime = 0;
+	double minTime = DBL_MAX;
+	double maxTime = 0;
+
+	for (unsigned int i = 0; i < a_steps; i++)
+	{
+		Clock::time_point start = Clock::now();
+
+		stepHeadless();
+
+		double time = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+		totalTime += time;
+		minTime = glm::min(minTime, time);
+		maxTime = glm::max(maxTime, time);
+	}
+
+	if (a_steps == 0)
+		return;
+
+	printf("Headless: %u steps of %.4fs, %u bodies, %u worker threads\n",
+		a_steps, m_fixedTimeStep, m_renderState.getBodyCount(), m_taskPool.getWorkerCount());
+	printf("  total %.2fms, mean %.4fms, min %.4fms, max %.4fms per step\n",
+		totalTime, totalTime / a_steps, minTime, maxTime);
+	printf("  %.1f steps per second, %.1fx real time\n",
+		a_steps / (totalTime / 1000.0), (a_steps * m_fixedTimeStep) / (totalTime / 1000.0));
+}
+
+void PhysicsDemoScene::stepHeadless()
+{
+	Profiler::newFrame();
+	PROFILE_ZONE("step");
+
+	m_renderState.addBodies(g_PhysXActors);
+	runSceneQueries();
+	stepPhysX(m_fixedTimeStep);
+	m_projectilePool.update();
+}
+
 bool PhysicsDemoScene::update()
 {
 	if (Application::update() == false)
 		return false;
 
+	Profiler::newFrame();
+	PROFILE_ZONE("update");
+
 	//check if window size has changed
 	int screen_width, screen_height;
 	glfwGetWindowSize(m_window, &screen_width, &screen_height);
@@ -140,8 +400,29 @@ bool PhysicsDemoScene::update()
 		projection2D = glm::ortho(-m_screen_size.x / 2.0f, m_screen_size.x / 2.0f, -m_screen_size.y / 2.0f, m_screen_size.y / 2.0f);
 	}
 
+	//count what the last frame allocated on this thread, loaders and PhysX workers are their own business
+	unsigned int allocationCount = GetThreadAllocationCount();
+	m_frameAllocations = allocationCount - m_lastAllocationCount;
+	m_lastAllocationCount = allocationCount;
+
+	//once warmed up, a frame which didn't add any actors or upload a streamed model shouldn't need the heap
+	bool steadyState = m_frameCount > 60 && m_renderState.getBodyCount() == m_lastBodyCount &&
+					   m_assets.getPendingCount() == 0;
+	if (m_assertNoFrameAllocations && steadyState)
+		assert(m_frameAllocations == 0 && "a settled frame made heap allocations");
+
+	m_lastBodyCount = m_renderState.getBodyCount();
+	m_frameCount++;
+
+	//reset gizmos and frame scratch memory, primitive instances persist
 	Gizmos::clear();
 
+	//upload this frame's share of any models streaming in
+	m_assets.update();
+
+	//collect the step that was left running over the last frame
+	fetchPhysX();
+
 	//get deltatime
 	float dt = (float)glfwGetTime();
 	glfwSetTime(0.0);
@@ -149,6 +430,14 @@ bool PhysicsDemoScene::update()
 	//update camera
 	m_camera.update(dt);
 
+	runSceneQueries();
+
+	m_eventHandler->addGizmos(m_frustum);
+
+	//mark what we're aiming at
+	if (m_aimHit)
+		Gizmos::addAABBFilled(vec3(m_aimPoint.x, m_aimPoint.y, m_aimPoint.z), vec3(0.1f), vec4(1, 0, 0, 1));
+
 	//INPUT
 
 	//if alt is down make holding LMB fire constantly
@@ -166,6 +455,18 @@ bool PhysicsDemoScene::update()
 	}
 	mouse1State_last = mouse1State;
 
+	//M drops a model where we're aiming
+	bool spawnKeyState = glfwGetKey(m_window, GLFW_KEY_M) == GLFW_PRESS;
+	if (spawnKeyState && !spawnKeyState_last)
+	{
+		vec3 position = vec3(m_camera.world[3]) - vec3(m_camera.world[2]) * 10.0f;
+		if (m_aimHit)
+			position = vec3(m_aimPoint.x, m_aimPoint.y, m_aimPoint.z);
+
+		spawnModel(position + vec3(0, 5, 0));
+	}
+	spawnKeyState_last = spawnKeyState;
+
 
 
 	//update PhysX
@@ -178,18 +479,48 @@ bool PhysicsDemoScene::update()
 
 void PhysicsDemoScene::draw()
 {
+	PROFILE_ZONE("draw");
+
 	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-	//draw tank
-	//m_model->Render((float*)&m_camera.view_proj);
+	//draw models, visible meshes are gathered then drawn together
+	{
+		PROFILE_GPU_ZONE("models");
+		m_modelRenderer.clear();
+		for (auto model : m_models)
+			m_modelRenderer.add(*model, &m_frustum);
+		m_modelRenderer.draw(m_camera.view_proj);
+	}
 
 	//draw grid
 	DrawGizmoGrid(50);
 
-	Gizmos::draw(m_camera.proj, m_camera.view);
-	Gizmos::draw2D(projection2D);
+	{
+		PROFILE_GPU_ZONE("primitives");
+		m_primitives.draw(m_camera.view_proj);
+	}
+
+	{
+		PROFILE_GPU_ZONE("gizmos");
+		Gizmos::draw(m_camera.proj, m_camera.view);
+	}
+
+	//frame timings, top left
+	Profiler::addOverlay(vec2(-m_screen_size.x / 2.0f + 10, m_screen_size.y / 2.0f - 10));
 
-	glfwSwapBuffers(m_window);
+	//simulation statistics, top right
+	if (m_showStats)
+		m_simStats.addOverlay(vec2(m_screen_size.x / 2.0f - 10 - 2.0f * SimulationStats::HISTORY_SIZE, m_screen_size.y / 2.0f - 10));
+
+	{
+		PROFILE_GPU_ZONE("gizmos2D");
+		Gizmos::draw2D(projection2D);
+	}
+
+	{
+		PROFILE_ZONE("swapBuffers");
+		glfwSwapBuffers(m_window);
+	}
 	glfwPollEvents();
 }
 
@@ -198,7 +529,19 @@ void PhysicsDemoScene::setupPhysX()
 	PxAllocatorCallback *myCallback = new myAllocator();
 	g_PhysicsFoundation = PxCreateFoundation(PX_PHYSICS_VERSION, *myCallback, g_DefaultErrorCallback);
 
-	g_Physics = PxCreatePhysics(PX_PHYSICS_VERSION, *g_PhysicsFoundation, PxTolerancesScale());
+	//capturing needs the SDK's profile zones routed through a buffered profiler
+	PxProfileZoneManager* profileZoneManager = nullptr;
+	if (m_captureFile != nullptr)
+	{
+		m_bufferedProfiler = PxDefaultBufferedProfilerCreate(*g_PhysicsFoundation, "PhysXSDK PxTaskManager");
+		profileZoneManager = &m_bufferedProfiler->getProfileZoneManager();
+
+		std::string filename = std::string(m_captureFile) + ".pxprof";
+		if (m_profileCapture.open(filename.c_str(), m_captureLimit))
+			m_bufferedProfiler->addBufferedProfilerCallback(m_profileCapture);
+	}
+
+	g_Physics = PxCreatePhysics(PX_PHYSICS_VERSION, *g_PhysicsFoundation, PxTolerancesScale(), false, profileZoneManager);
 
 	PxInitExtensions(*g_Physics);
 
@@ -210,59 +553,349 @@ void PhysicsDemoScene::setupPhysX()
 	//create physics scene	
 	PxSceneDesc sceneDesc(g_Physics->getTolerancesScale());
 	sceneDesc.gravity = PxVec3(0.0f,-10.0f,0.0f);
-	sceneDesc.filterShader = &PxDefaultSimulationFilterShader;
-	sceneDesc.cpuDispatcher = PxDefaultCpuDispatcherCreate(1);
+	sceneDesc.filterShader = &SimulationEvents::filterShader;
+	sceneDesc.simulationEventCallback = &m_simulationEvents;
+	sceneDesc.flags |= PxSceneFlag::eENABLE_ACTIVETRANSFORMS;	//lets us only copy out what moved
+
+	//broadphase, MBP reports anything leaving its regions so it can be despawned
+	const PxU32 maxRegions = 256;
+	sceneDesc.broadPhaseType = m_broadPhaseType;
+	sceneDesc.broadPhaseCallback = &m_simulationEvents;
+	if (m_broadPhaseType == PxBroadPhaseType::eMBP)
+		sceneDesc.limits.maxNbRegions = maxRegions;
+
+	//start the worker threads and let PhysX use them
+	m_taskPool.startup(m_workerThreads);
+	g_CpuDispatcher = new myCpuDispatcher(&m_taskPool);
+	sceneDesc.cpuDispatcher = g_CpuDispatcher;
 
 	g_PhysicsScene = g_Physics->createScene(sceneDesc);
 
+	//MBP needs regions before anything is added, a grid over the world with nothing above or below
+	if (m_broadPhaseType == PxBroadPhaseType::eMBP)
+	{
+		PxBroadPhaseCaps caps;
+		g_PhysicsScene->getBroadPhaseCaps(caps);
+
+		PxU32 limit = PxMin(caps.maxNbRegions, maxRegions);
+		PxU32 subdivisions = PxClamp((PxU32)m_worldSubdivisions, 1u, (PxU32)sqrtf((float)limit));
+
+		PxBounds3 regions[maxRegions];
+		PxU32 count = PxBroadPhaseExt::createRegionsFromWorldBounds(regions, m_worldBounds, subdivisions);
+
+		for (PxU32 i = 0; i < count; i++)
+		{
+			PxBroadPhaseRegion region;
+			region.bounds = regions[i];
+			region.userData = nullptr;
+			g_PhysicsScene->addBroadPhaseRegion(region);
+		}
+	}
+
+	//related actors share broadphase entries when m_aggregateSize is set
+	m_aggregates.create(g_Physics, g_PhysicsScene, m_aggregateSize);
+
+	//room for a busy step's worth of events, anything past this is dropped
+	m_simulationEvents.create(1024);
+	m_eventHandler = new DemoEventHandler(this);
+
+	//one batch for all of a frame's raycasts, sweeps and overlaps
+	m_queries.create(g_PhysicsScene, 64, 64, 16);
 
 }
 
 void PhysicsDemoScene::updatePhysX(float dt)
 {
+	PROFILE_ZONE("updatePhysX");
+
+	//start tracking any actors added since last frame
+	m_renderState.addBodies(g_PhysXActors);
+
 	if (dt <= 0)
 		return;
 
-	g_PhysicsScene->simulate(dt);
+	//add the frame time to the accumulator, capped so a slow frame can't queue up endless steps
+	m_accumulator += dt;
+
+	float maxAccumulated = m_fixedTimeStep * m_maxSubSteps;
+	if (m_accumulator > maxAccumulated)
+		m_accumulator = maxAccumulated;
 
-	while (g_PhysicsScene->fetchResults() == false)
+	//work out how many fixed steps are due this frame
+	unsigned int steps = 0;
+	while (m_accumulator >= m_fixedTimeStep)
 	{
-		//dont need to do anything yet but have ot fetch results
+		m_accumulator -= m_fixedTimeStep;
+		steps++;
 	}
 
-	//update player controller
-	updatePlayerController(dt);
+	//when pipelining the last step is left running while the frame is drawn
+	unsigned int syncSteps = steps;
+	if (m_pipelinePhysics && steps > 0)
+		syncSteps = steps - 1;
+
+	for (unsigned int i = 0; i < syncSteps; i++)
+	{
+		stepPhysX(m_fixedTimeStep);
+	}
+
+	//take any projectiles which have left the world out of the scene
+	m_projectilePool.update();
+
+	//how far we are between the previous step and the current one
+	m_renderAlpha = m_accumulator / m_fixedTimeStep;
 
-	//update all models with collision shapes
-	for (auto actor : g_PhysXActors)
+	//only bodies which are moving, or have just stopped, need drawing somewhere new
+	const std::vector<unsigned int>& dirty = m_renderState.getDirtyBodies();
+
+	//work out where they should be drawn, spread across the task pool
 	{
-		if (actor->userData != nullptr)
+		PROFILE_ZONE("renderPoses");
+		m_taskPool.parallelFor((unsigned int)dirty.size(), 64, [this, &dirty](unsigned int d)
 		{
-			PxMat44 m = actor->getGlobalPose();
-			mat4 M = *((mat4*)(&m));	//cast to glm matrix
+			unsigned int i = dirty[d];
+
+			m_renderState.m_renderPoses[i] = m_renderState.getRenderPose(i, m_renderAlpha);
+			m_renderState.updateBounds(i);
 
-			FBXActor* mesh = (FBXActor*)actor->userData;
-			mesh->m_world = M;	//set position
+			//update models with collision shapes
+			if (m_renderState.m_userData[i] != nullptr)
+			{
+				PxMat44 m = PxMat44(m_renderState.m_renderPoses[i]);
+				mat4 M = *((mat4*)(&m));	//cast to glm matrix
+
+				FBXActor* mesh = (FBXActor*)m_renderState.m_userData[i];
+				mesh->m_world = M;	//set position
+			}
+		});
+	}
+
+	//test bounds against the camera, all of them if it moved, otherwise only the bodies which did
+	unsigned int bodyCount = m_renderState.getBodyCount();
+	bool cameraMoved = m_camera.view_proj != m_cullViewProj;
+	{
+		PROFILE_ZONE("cull");
+
+		m_inView.resize(bodyCount, 1);
+		m_widgetVisible.resize(bodyCount, 1);	//instances start out showing
+
+		if (cameraMoved)
+		{
+			m_frustum.setFromMatrix(m_camera.view_proj);
+			m_cullViewProj = m_camera.view_proj;
+
+			if (bodyCount > 0)
+			{
+				m_frustum.testSpheres(m_renderState.m_sphereX.data(), m_renderState.m_sphereY.data(), m_renderState.m_sphereZ.data(),
+					m_renderState.m_sphereRadius.data(), bodyCount, m_inView.data());
+			}
+		}
+		else
+		{
+			for (auto body : dirty)
+			{
+				vec3 centre(m_renderState.m_sphereX[body], m_renderState.m_sphereY[body], m_renderState.m_sphereZ[body]);
+				m_inView[body] = m_frustum.testSphere(centre, m_renderState.m_sphereRadius[body]) ? 1 : 0;
+			}
 		}
 	}
 
-	//Add widgets to represent all the physX actors which are in the scene
-	for (auto actor : g_PhysXActors)
+	//Add widgets to represent new physX shapes, then show, hide and move the ones which changed
 	{
-		PxU32 nShapes = actor->getNbShapes();
-		PxShape** shapes = new PxShape*[nShapes];
-		actor->getShapes(shapes, nShapes);
+		PROFILE_ZONE("addWidgets");
+		for (; m_widgetCount < m_renderState.m_shapes.size(); m_widgetCount++)
+		{
+			RenderState::Shape& shape = m_renderState.m_shapes[m_widgetCount];
+			shape.instance = addWidget(shape, m_renderState.m_renderPoses[shape.body] * shape.localPose);
+		}
 
-		//Render all the shapes in the physX actor
-		while (nShapes--)
+		unsigned int count = cameraMoved ? bodyCount : (unsigned int)dirty.size();
+		for (unsigned int i = 0; i < count; i++)
 		{
-			addWidget(shapes[nShapes], actor);
+			unsigned int body = cameraMoved ? i : dirty[i];
+
+			//retired projectiles aren't in the scene
+			bool visible = m_renderState.m_enabled[body] && m_inView[body];
+
+			//off screen bodies aren't moved until they come back into view
+			bool changed = visible != (m_widgetVisible[body] != 0);
+			if (changed == false && (visible == false || m_renderState.isDirty(body) == false))
+				continue;
+
+			m_widgetVisible[body] = visible;
+
+			unsigned int end = m_renderState.m_shapeStart[body] + m_renderState.m_shapeCount[body];
+			for (unsigned int s = m_renderState.m_shapeStart[body]; s < end; s++)
+			{
+				const RenderState::Shape& shape = m_renderState.m_shapes[s];
+				updateWidget(shape, m_renderState.m_renderPoses[body] * shape.localPose, visible);
+			}
 		}
 
-		delete[] shapes;
+		m_renderState.clearSettled();
+	}
+
+	//start the deferred step, it is fetched at the start of next frame
+	if (syncSteps < steps)
+		kickPhysX(m_fixedTimeStep);
+}
+
+void PhysicsDemoScene::stepPhysX(float step)
+{
+	kickPhysX(step);
+	fetchPhysX();
+}
+
+void PhysicsDemoScene::kickPhysX(float step)
+{
+	PROFILE_ZONE("simulate");
+
+	g_PhysicsScene->simulate(step);
+	m_simulating = true;
+}
+
+void PhysicsDemoScene::fetchPhysX()
+{
+	if (m_simulating == false)
+		return;
+
+	PROFILE_ZONE("fetchPhysX");
+
+	//block until the step is done, the worker threads do the waiting instead of us spinning
+	std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+
+	g_PhysicsScene->fetchResults(true);
+	m_simulating = false;
+
+	m_fetchWaitTime = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+	recordStats();
+
+	//copy out the poses of everything that moved
+	m_renderState.update(g_PhysicsScene);
+
+	//update player controller
+	updatePlayerController(m_fixedTimeStep);
+
+	//react to what happened during the step and the controller's move
+	m_simulationEvents.dispatch(*m_eventHandler);
+}
+
+void PhysicsDemoScene::despawn(PxRigidActor* a_actor)
+{
+	//the pool recycles its own
+	if (m_projectilePool.retire(a_actor))
+		return;
+
+	//already gone, actors with several shapes are reported once per shape
+	if (a_actor->getScene() == nullptr)
+		return;
+
+	//character controllers own their kinematic actors
+	PxRigidDynamic* dynamic = a_actor->is<PxRigidDynamic>();
+	if (dynamic != nullptr && (dynamic->getRigidDynamicFlags() & PxRigidDynamicFlag::eKINEMATIC))
+		return;
+
+	m_aggregates.remove(*a_actor);
+
+	unsigned int body = m_renderState.findBody(a_actor);
+	m_renderState.setEnabled(body, false);
+
+	//a model goes with its actor, otherwise it would be drawn frozen where it left
+	auto model = std::find(m_models.begin(), m_models.end(), (FBXActor*)a_actor->userData);
+	if (a_actor->userData != nullptr && model != m_models.end())
+	{
+		if (*model == m_model)
+			m_model = nullptr;
+		delete *model;
+		m_models.erase(model);
+
+		a_actor->userData = nullptr;
+		if (body < m_renderState.getBodyCount())
+			m_renderState.m_userData[body] = nullptr;
 	}
 }
 
+void PhysicsDemoScene::runSceneQueries()
+{
+	PROFILE_ZONE("sceneQueries");
+
+	//a sphere just narrower than the player swept down from inside the bottom of the capsule
+	PxCapsuleController* player = static_cast<PxCapsuleController*>(gPlayerController);
+	PxExtendedVec3 foot = player->getFootPosition();
+
+	float radius = player->getRadius() * 0.9f;
+	float distance = player->getRadius() - radius + player->getContactOffset() + 0.1f;
+	PxTransform pose(PxVec3((float)foot.x, (float)foot.y + radius, (float)foot.z));
+
+	unsigned int ground = m_queries.sweep(PxSphereGeometry(radius), pose, PxVec3(0, -1, 0), distance, SceneQueries::GROUP_PLAYER);
+
+	//aim through the cursor, past our own shots
+	unsigned int aim = SceneQueries::INVALID;
+	if (m_window != nullptr)
+	{
+		double x, y;
+		glfwGetCursorPos(m_window, &x, &y);
+
+		vec3 origin, direction;
+		m_camera.getPickRay((float)x, (float)y, m_screen_size.x, m_screen_size.y, origin, direction);
+
+		aim = m_queries.raycast(PxVec3(origin.x, origin.y, origin.z), PxVec3(direction.x, direction.y, direction.z), 1000.0f,
+			SceneQueries::GROUP_PROJECTILE | SceneQueries::GROUP_PLAYER);
+	}
+
+	m_queries.execute();
+
+	//if y is greater then 0.3 we assume this is solid ground
+	m_onGround = false;
+	if (ground != SceneQueries::INVALID)
+	{
+		const PxSweepQueryResult& result = m_queries.getSweep(ground);
+		m_onGround = result.hasBlock && result.block.normal.y > 0.3f;
+	}
+
+	m_aimHit = false;
+	if (aim != SceneQueries::INVALID)
+	{
+		const PxRaycastQueryResult& result = m_queries.getRaycast(aim);
+		m_aimHit = result.hasBlock;
+		if (m_aimHit)
+			m_aimPoint = result.block.position;
+	}
+}
+
+void PhysicsDemoScene::recordStats()
+{
+	SimulationStats::Sample sample;
+	sample.actors = (unsigned int)g_PhysXActors.size();
+	sample.aggregates = m_aggregates.getAggregateCount();
+	sample.aggregatedShapes = m_aggregates.getShapeCount();
+	sample.fetchWaitMs = (float)m_fetchWaitTime;
+	sample.gizmoLines = 0;
+	sample.gizmoTris = 0;
+	sample.drawCalls = 0;
+
+	//the gizmo counts are from the last frame drawn
+	if (m_headless == false)
+	{
+		Gizmos::Stats lines = Gizmos::getStats(Gizmos::LINES);
+		Gizmos::Stats tris = Gizmos::getStats(Gizmos::TRIS);
+		Gizmos::Stats transparentTris = Gizmos::getStats(Gizmos::TRANSPARENT_TRIS);
+
+		sample.gizmoLines = lines.submitted;
+		sample.gizmoTris = tris.submitted + transparentTris.submitted;
+
+		//each gizmo list with something in it is one draw
+		sample.drawCalls = m_primitives.getDrawCallCount() + m_modelRenderer.getDrawCallCount();
+		for (unsigned int list = 0; list < Gizmos::LIST_COUNT; list++)
+		{
+			if (Gizmos::getStats((Gizmos::List)list).submitted > 0)
+				sample.drawCalls++;
+		}
+	}
+
+	m_simStats.record(g_PhysicsScene, sample);
+}
 
 void PhysicsDemoScene::setupVisualDebugger()
 {
@@ -277,6 +910,14 @@ void PhysicsDemoScene::setupVisualDebugger()
 
 	PxVisualDebuggerConnectionFlags connectionFlags = PxVisualDebuggerExt::getAllConnectionFlags();
 
+	//capturing goes to a file PVD can open later, so nothing has to be listening
+	if (m_captureFile != nullptr)
+	{
+		std::string filename = std::string(m_captureFile) + ".pxd2";
+		ProfileCapture::connectPvd(g_Physics->getPvdConnectionManager(), filename.c_str(), m_captureLimit, connectionFlags);
+		return;
+	}
+
 	// Now try to connect to PVD
 	auto theConnection = PxVisualDebuggerExt::createConnection(g_Physics->getPvdConnectionManager(), pvd_host_ip, port, timeout, connectionFlags);
 
@@ -325,14 +966,22 @@ void PhysicsDemoScene::setupCollisionHierachies()
 	//add it to the physX scene
 	g_PhysicsScene->addActor(*plane);
 
-	//create actor with a model
-	m_model = new FBXActor();
-	m_model->Init("./data/models/soulspear.fbx");
-	m_model->m_world[3] = vec4(0,2,0,1);
+	//create actor with a model, it streams in over the next few frames
+	spawnModel(vec3(0, 2, 0));
+	m_model = m_models.back();
+
+}
+
+void PhysicsDemoScene::spawnModel(const vec3& a_position)
+{
+	FBXActor* model = new FBXActor();
+	model->m_world = glm::translate(a_position);
 
-	//model collision
-	m_model->createCollisionShapes(this);
+	//collision straight away, the model itself follows
+	model->createCollisionShapes(this);
+	m_assets.load(model, "./data/models/soulspear.fbx");
 
+	m_models.push_back(model);
 }
 
 void PhysicsDemoScene::setupPlayerController()
@@ -358,7 +1007,7 @@ void PhysicsDemoScene::setupPlayerController()
 	g_PhysXActors.push_back(actor);
 
 	//create player controller
-	myHitReport = new MyControllerHitReport();
+	myHitReport = new MyControllerHitReport(&m_simulationEvents);
 	gCharacterManager = PxCreateControllerManager(*g_PhysicsScene);
 
 	//describe our controller
@@ -375,11 +1024,15 @@ void PhysicsDemoScene::setupPlayerController()
 
 	gPlayerController->setPosition(PxExtendedVec3(0,1.5f,0));
 
+	//scene queries made on the player's behalf skip its own capsule
+	PxShape* playerShape;
+	gPlayerController->getActor()->getShapes(&playerShape, 1);
+	playerShape->setQueryFilterData(PxFilterData(SceneQueries::GROUP_PLAYER, 0, 0, 0));
+
 	//set up some variables to control our player with
 	_characterYVelocity = 0;	//initialize character velocity
 	_characterRotation = 0;		// and rotation
 	_playerGravity = -0.5f;		//setup the player gravity
-	myHitReport->clearPlayerContactNormal();	//initialize the contact normal (what we are in contact with)
 
 	g_PhysXActors.push_back(gPlayerController->getActor());
 
@@ -391,9 +1044,8 @@ void PhysicsDemoScene::updatePlayerController(float dt)
 	float movementSpeed = 10.0f;
 	float rotationSpeed = 3.0f;
 
-	//check for contact normal
-	//if y is greater then 0.3 we assume this is sollid ground.
-	if (myHitReport->getPlayerContactNormal().y > 0.3f)
+	//the ground sweep from the last batch of scene queries
+	if (m_onGround)
 	{
 		_characterYVelocity = -0.1f;
 		onGround = true;
@@ -404,35 +1056,38 @@ void PhysicsDemoScene::updatePlayerController(float dt)
 		onGround = false;
 	}
 
-	myHitReport->clearPlayerContactNormal();
-
 	const PxVec3 up(0,1,0);
 
 	//scan the keys and setup our intended velocity based on our global transform
 	PxVec3 velocity(0, _characterYVelocity, 0);
-	if (glfwGetKey(m_window, GLFW_KEY_UP) == GLFW_PRESS)
-	{
-		velocity.x -= movementSpeed * dt;
-	}
-	if (glfwGetKey(m_window, GLFW_KEY_DOWN) == GLFW_PRESS)
-	{
-		velocity.x += movementSpeed * dt;
-	}
 
-	if (glfwGetKey(m_window, GLFW_KEY_LEFT) == GLFW_PRESS)
+	//no keyboard when headless
+	if (m_window != nullptr)
 	{
-		_characterRotation += rotationSpeed * dt;
-	}
+		if (glfwGetKey(m_window, GLFW_KEY_UP) == GLFW_PRESS)
+		{
+			velocity.x -= movementSpeed * dt;
+		}
+		if (glfwGetKey(m_window, GLFW_KEY_DOWN) == GLFW_PRESS)
+		{
+			velocity.x += movementSpeed * dt;
+		}
 
-	if (glfwGetKey(m_window, GLFW_KEY_RIGHT) == GLFW_PRESS)
-	{
-		_characterRotation -= rotationSpeed * dt;
-	}
+		if (glfwGetKey(m_window, GLFW_KEY_LEFT) == GLFW_PRESS)
+		{
+			_characterRotation += rotationSpeed * dt;
+		}
 
-	if (glfwGetKey(m_window, GLFW_KEY_SPACE) == GLFW_PRESS)
-	{
-		_characterYVelocity = 10.0f;
-		velocity.y - 10.0f;
+		if (glfwGetKey(m_window, GLFW_KEY_RIGHT) == GLFW_PRESS)
+		{
+			_characterRotation -= rotationSpeed * dt;
+		}
+
+		if (glfwGetKey(m_window, GLFW_KEY_SPACE) == GLFW_PRESS)
+		{
+			_characterYVelocity = 10.0f;
+			velocity.y - 10.0f;
+		}
 	}
 
 	//To do.. add code to control z movement and jumping
@@ -450,146 +1105,94 @@ void PhysicsDemoScene::updatePlayerController(float dt)
 
 void PhysicsDemoScene::shootSphere()
 {
-	float density = 100;
-	PxSphereGeometry projectile(0.4f);
-
-	PxTransform transform(PxVec3(m_camera.world[3].x, m_camera.world[3].y - 1, m_camera.world[3].z));
-	PxRigidDynamic* actor = PxCreateDynamic(*g_Physics, transform, projectile, *g_PhysicsMaterial, density);
+	PxVec3 position(m_camera.world[3].x, m_camera.world[3].y - 1, m_camera.world[3].z);
 
 	float muzzleSpeed = -100;
 
 	//set intial velocity
 	vec3 direction(m_camera.world[2]);
 	PxVec3 velocity = PxVec3(direction.x, direction.y, direction.z) * muzzleSpeed;
-	actor->setLinearVelocity(velocity, true);
 
-	//add it to the PhysX scene
-	g_PhysicsScene->addActor(*actor);
-	g_PhysXActors.push_back(actor);
+	//head for whatever is under the cursor
+	if (m_aimHit && (m_aimPoint - position).magnitude() > 1.0f)
+		velocity = (m_aimPoint - position).getNormalized() * -muzzleSpeed;
+
+	//take a projectile from the pool
+	m_projectilePool.spawn(position, velocity);
 }
 
 //Widgets
 
-void PhysicsDemoScene::addWidget(PxShape* shape, PxRigidActor* actor)
+unsigned int PhysicsDemoScene::addWidget(const RenderState::Shape& shape, const PxTransform& pose)
 {
-	PxGeometryType::Enum type = shape->getGeometryType();
-
-	switch (type)
+	switch (shape.type)
 	{
 
 		case physx::PxGeometryType::eBOX:
-			addBox(shape, actor);
-			break;
+			return addBox(shape, pose);
 		case physx::PxGeometryType::eSPHERE:
-			addSphere(shape, actor);
-			break;
+			return addSphere(shape, pose);
 		case physx::PxGeometryType::eCAPSULE:
-			addCapsule(shape, actor);
-			break;
+			return addCapsule(shape, pose);
 		default:
-			break;
+			return PrimitiveRenderer::INVALID;
 	}
 }
 
-void PhysicsDemoScene::addBox(PxShape* pShape, PxRigidActor* actor)
+void PhysicsDemoScene::updateWidget(const RenderState::Shape& shape, const PxTransform& pose, bool visible)
 {
-	//get the geometry for this PhysX collision volume
-	PxBoxGeometry geometry;
-	float width = 1, height = 1, length = 1;
-	bool status = pShape->getBoxGeometry(geometry);
-	if (status)
-	{
-		width = geometry.halfExtents.x;
-		height = geometry.halfExtents.y;
-		length = geometry.halfExtents.z;
-	}
-
-	//get the transform for this PhysX collision volume
-	PxMat44 m(PxShapeExt::getGlobalPose(*pShape, *actor));
-	mat4 M(m.column0.x, m.column0.y, m.column0.z, m.column0.w,
-		m.column1.x, m.column1.y, m.column1.z, m.column1.w,
-		m.column2.x, m.column2.y, m.column2.z, m.column2.w,
-		m.column3.x, m.column3.y, m.column3.z, m.column3.w);
+	//planes and meshes aren't drawn as primitives
+	if (shape.instance == PrimitiveRenderer::INVALID)
+		return;
 
-	vec3 position;
+	vec3 position = vec3(pose.p.x, pose.p.y, pose.p.z);
+	glm::quat q = glm::quat(pose.q.w, pose.q.x, pose.q.y, pose.q.z);
 
-	//get the position out of the transform
-	position.x = m.getPosition().x;
-	position.y = m.getPosition().y;
-	position.z = m.getPosition().z;
+	m_primitives.setTransform(shape.instance, position, q);
+	m_primitives.setVisible(shape.instance, visible);
+}
 
-	vec3 extents = vec3(width, height, length);
-	vec4 colour = vec4(1,0,0,1);
+unsigned int PhysicsDemoScene::addBox(const RenderState::Shape& shape, const PxTransform& pose)
+{
+	//position
+	vec3 position = vec3(pose.p.x, pose.p.y, pose.p.z);
 
-	if (actor->getName() != nullptr && strcmp(actor->getName(), "Pickup1"))	 //pickups are green
-		colour = vec4(0,1,0,1);
+	//rotation
+	glm::quat q = glm::quat(pose.q.w, pose.q.x, pose.q.y, pose.q.z);
 
-	//create our box gizmo
-	Gizmos::addAABBFilled(position, extents, colour, &M);
+	vec3 extents = vec3(shape.size.x, shape.size.y, shape.size.z);
 
+	//add an instance of the unit box
+	return m_primitives.addBox(position, q, extents, shape.colour);
 }
 
-void PhysicsDemoScene::addSphere(PxShape* pShape, PxRigidActor* actor)
+unsigned int PhysicsDemoScene::addSphere(const RenderState::Shape& shape, const PxTransform& pose)
 {
-	PxSphereGeometry geometry;
-	float radius = 1;
-
-	//get the geometry for this PhysX collision volume
-	bool status = pShape->getSphereGeometry(geometry);
-	if (status)
-	{
-		radius = geometry.radius;
-	}
+	float radius = shape.size.x;
 
 	//position
-	PxTransform pose = actor->getGlobalPose();
 	vec3 position = vec3(pose.p.x, pose.p.y, pose.p.z);
 
 	//rotation
 	glm::quat q = glm::quat(pose.q.w, pose.q.x, pose.q.y, pose.q.z);
-	mat4 rotation = mat4(q);
-
-	//colour
-	vec4 colour = vec4(1, 0, 0, 1);
-
-	if (actor->getName() != nullptr && strcmp(actor->getName(), "Pickup1"))	 //pickups are green
-		colour = vec4(0, 1, 0, 1);
 
-
-	//create Gizmo
-	Gizmos::addSphereFilled(position, radius, 12, 12, colour, &rotation);
+	//add an instance of the unit sphere
+	return m_primitives.addSphere(position, q, radius, shape.colour);
 }
 
-void PhysicsDemoScene::addCapsule(PxShape* pShape, PxRigidActor* actor)
+unsigned int PhysicsDemoScene::addCapsule(const RenderState::Shape& shape, const PxTransform& pose)
 {
-	PxCapsuleGeometry geometry;
-	float radius = 1;
-	float halfHeight = 1;
-
-	//get the geometry for this PhysX collision volume
-	bool status = pShape->getCapsuleGeometry(geometry);
-	if (status)
-	{
-		radius = geometry.radius;
-		halfHeight = geometry.halfHeight;
-	}
+	float radius = shape.size.x;
+	float halfHeight = shape.size.y;
 
 	//position
-	PxTransform pose = actor->getGlobalPose();
 	vec3 position = vec3(pose.p.x, pose.p.y, pose.p.z);
 
 	//rotation
 	glm::quat q = glm::quat(pose.q.w, pose.q.x, pose.q.y, pose.q.z);
-	mat4 rotation = mat4(q);
-
-	//colour
-	vec4 colour = vec4(1, 0, 0, 1);
-
-	if (actor->getName() != nullptr && strcmp(actor->getName(), "Pickup1"))	 //pickups are green
-		colour = vec4(0, 1, 0, 1);
 
-	//create Gizmo
-	Gizmos::addCapsule(position, (halfHeight * 2) + (2 * radius), radius, 12, 12, colour, &rotation);
+	//add an instance of the unit capsule
+	return m_primitives.addCapsule(position, q, radius, halfHeight, shape.colour);
 }
 
 void DrawGizmoGrid(int a_size)
@@ -11,10 +11,24 @@
 #include <vector>
 
 #include "FBXActor.h"
+#include "TaskPool.h"
+#include "ProjectilePool.h"
+#include "RenderState.h"
+#include "PrimitiveRenderer.h"
+#include "ModelRenderer.h"
+#include "Frustum.h"
+#include "ProfileCapture.h"
+#include "SimulationStats.h"
+#include "SceneQueries.h"
+#include "SimulationEvents.h"
+#include "AggregateBuilder.h"
+#include "ResourceRegistry.h"
+#include "AssetStreamer.h"
 
 using namespace physx;
 
 class MyControllerHitReport;
+class DemoEventHandler;
 
 class PhysicsDemoScene : public Application
 {
@@ -24,17 +38,36 @@ public:
 	virtual bool update();
 	virtual void draw();
 
+	bool setupGraphics();
+
+	//steps the scene a_steps times with nothing drawn and prints the timings
+	void runHeadless(unsigned int a_steps);
+
+	//one fixed step with nothing drawn
+	void stepHeadless();
+
 	//physics
 	void setupPhysX();
 	void updatePhysX(float dt);
+	void stepPhysX(float step);
+	void kickPhysX(float step);
+	void fetchPhysX();
+	void recordStats();
+
+	//queues this frame's picking and ground checks and runs them as one batch
+	void runSceneQueries();
+
+	//takes an actor which has left the world out of the scene, projectiles go back to their pool
+	void despawn(PxRigidActor* a_actor);
 
 	void setupVisualDebugger();
 
-	//Widgets
-	void addWidget(PxShape* shape, PxRigidActor* actor);
-	void addBox(PxShape* pShape, PxRigidActor* actor);
-	void addSphere(PxShape* pShape, PxRigidActor* actor);
-	void addCapsule(PxShape* pShape, PxRigidActor* actor);
+	//Widgets, each returns the primitive instance representing the shape
+	unsigned int addWidget(const RenderState::Shape& shape, const PxTransform& pose);
+	unsigned int addBox(const RenderState::Shape& shape, const PxTransform& pose);
+	unsigned int addSphere(const RenderState::Shape& shape, const PxTransform& pose);
+	unsigned int addCapsule(const RenderState::Shape& shape, const PxTransform& pose);
+	void updateWidget(const RenderState::Shape& shape, const PxTransform& pose, bool visible);
 
 	//tutorials
 	void setupTutorial();
@@ -47,8 +80,30 @@ public:
 	//shoot
 	void shootSphere();
 
+	//drops a soulspear at a_position, streamed in while it falls
+	void spawnModel(const vec3& a_position);
+
 
 public:		
+	//headless
+	bool m_headless = false;				//no window or GL context, see runHeadless
+	unsigned int m_headlessSteps = 1000;
+
+	//profiling
+	bool m_profile = false;					//time zones and show the overlay
+	const char* m_traceFile = nullptr;		//Chrome trace written here on shutdown
+
+	//offline capture
+	const char* m_captureFile = nullptr;	//PhysX events go to <file>.pxprof and PVD to <file>.pxd2 instead of a socket
+	size_t m_captureLimit = 64 << 20;		//bytes each capture file may grow to
+	PxDefaultBufferedProfiler* m_bufferedProfiler = nullptr;
+	ProfileCapture m_profileCapture;
+
+	//statistics
+	SimulationStats m_simStats;				//sampled after every fetchResults
+	bool m_showStats = false;				//draw the history as graphs
+	const char* m_statsFile = nullptr;		//every sample is appended here as CSV
+
 	//graphics
 	FlyCamera m_camera;
 	mat4 projection2D;
@@ -65,13 +120,75 @@ public:
 	PxMaterial* g_PhysicsMaterial;
 	PxMaterial* g_boxMaterial;
 	PxCooking* g_PhysicsCooker;
+	PxCpuDispatcher* g_CpuDispatcher;
+
+	//broadphase
+	PxBroadPhaseType::Enum m_broadPhaseType = PxBroadPhaseType::eSAP;
+	PxBounds3 m_worldBounds = PxBounds3(PxVec3(-500.0f), PxVec3(500.0f));	//MBP regions cover this, projectiles outside it are retired
+	unsigned int m_worldSubdivisions = 4;		//MBP regions along each side of m_worldBounds
+
+	//aggregates
+	AggregateBuilder m_aggregates;			//add compounds and groups of related actors through this
+	unsigned int m_aggregateSize = 0;		//most actors per aggregate, 0 gives every shape its own broadphase entry
+
+	//threading
+	TaskPool m_taskPool;				//shared by PhysX and our own per-frame jobs
+	unsigned int m_workerThreads = 0;	//0 = one per core
 
 	std::vector<PxRigidActor*> g_PhysXActors;
 
+	//fixed timestep
+	float m_fixedTimeStep = 1.0f / 60.0f;	//length of one simulation step
+	unsigned int m_maxSubSteps = 4;			//most steps we will take in a single frame
+	float m_accumulator = 0;				//frame time not yet simulated
+	float m_renderAlpha = 0;				//how far between the last two steps we are drawing
+
+	//pipelining
+	bool m_pipelinePhysics = true;			//leave the last step of a frame simulating while we draw
+	bool m_simulating = false;				//a step has been started and not fetched yet
+	double m_fetchWaitTime = 0;				//ms the last fetchResults spent blocked
+
+	RenderState m_renderState;	//poses and shapes of everything in g_PhysXActors, so drawing doesn't go back to PhysX
+	PrimitiveRenderer m_primitives;	//draws the shapes in m_renderState instanced
+	ModelRenderer m_modelRenderer;	//draws m_models instanced, one call per distinct mesh
+	unsigned int m_widgetCount = 0;	//shapes in m_renderState which have an instance in m_primitives
+
+	//culling
+	Frustum m_frustum;							//the camera's, as of the last cull
+	mat4 m_cullViewProj;						//matrix m_frustum came from, only cull everything again when it changes
+	std::vector<unsigned char> m_inView;		//per body, its bounds touch m_frustum
+	std::vector<unsigned char> m_widgetVisible;	//per body, its widgets are showing
+
+	//simulation events
+	SimulationEvents m_simulationEvents;	//queued during fetchResults
+	DemoEventHandler* m_eventHandler = nullptr;	//reacts to them once the fetch is done
+
+	//scene queries
+	SceneQueries m_queries;
+	bool m_onGround = false;				//the player's ground sweep hit something walkable
+	bool m_aimHit = false;					//the cursor is over a shape
+	PxVec3 m_aimPoint;						//where, shots head here while m_aimHit is set
+
+	//projectiles
+	ProjectilePool m_projectilePool;
+	unsigned int m_maxProjectiles = 256;	//most projectiles alive at once
+
+	//allocation tracking
+	unsigned int m_frameAllocations = 0;		//heap allocations the main thread made during the last frame
+	unsigned int m_lastAllocationCount = 0;
+	unsigned int m_frameCount = 0;
+	unsigned int m_lastBodyCount = 0;
+	bool m_assertNoFrameAllocations = false;	//assert once the scene has settled if a frame allocates, --assert-no-alloc
+
 	//input
 	bool mouse1State_last = false;
+	bool spawnKeyState_last = false;
 
-	FBXActor* m_model;
+	//models
+	ResourceRegistry m_resources;			//one copy of each model's buffers, textures and program however many actors draw it
+	AssetStreamer m_assets;					//loads them off the main thread and uploads a little each frame
+	std::vector<FBXActor*> m_models;		//drawn every frame, placeholders until they have streamed in
+	FBXActor* m_model = nullptr;
 
 	//
 	PxControllerManager* gCharacterManager;
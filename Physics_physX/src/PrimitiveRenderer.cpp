@@ -0,0 +1,407 @@
+#include "PrimitiveRenderer.h"
+
+#include "gl_core_4_4.h"
+#include "Profiler.h"
+
+#include <cstdio>
+
+PrimitiveRenderer::PrimitiveRenderer() : m_program(0), m_projectionViewUniform(-1), m_drawCalls(0) {}
+PrimitiveRenderer::~PrimitiveRenderer() {}
+
+void PrimitiveRenderer::create(unsigned int a_rows, unsigned int a_columns)
+{
+	// create shaders
+	const char* vsSource = "#version 330\n \
+					 in vec4 Position; \
+					 in vec3 Normal; \
+					 in vec4 InstancePosition; \
+					 in vec4 InstanceRotation; \
+					 in vec4 InstanceScale; \
+					 in vec4 InstanceColour; \
+					 out vec4 vColour; \
+					 out vec3 vNormal; \
+					 uniform mat4 ProjectionView; \
+					 vec3 rotate(vec4 q, vec3 v) { return v + 2.0 * cross(q.xyz, cross(q.xyz, v) + q.w * v); } \
+					 void main() { \
+						vec3 local = (Position.xyz * InstanceScale.xyz + vec3(Position.w * InstanceScale.w, 0, 0)) * InstancePosition.w; \
+						vNormal = rotate(InstanceRotation, Normal); \
+						vColour = InstanceColour; \
+						gl_Position = ProjectionView * vec4(rotate(InstanceRotation, local) + InstancePosition.xyz, 1); }";
+
+	const char* fsSource = "#version 330\n \
+					 in vec4 vColour; \
+					 in vec3 vNormal; \
+					 out vec4 FragColor; \
+					 void main() { \
+						float light = 0.4 + 0.6 * max(dot(normalize(vNormal), normalize(vec3(0.5, 1, 0.3))), 0); \
+						FragColor = vec4(vColour.rgb * light, vColour.a); }";
+
+	unsigned int vs = glCreateShader(GL_VERTEX_SHADER);
+	unsigned int fs = glCreateShader(GL_FRAGMENT_SHADER);
+
+	glShaderSource(vs, 1, (const char**)&vsSource, 0);
+	glCompileShader(vs);
+
+	glShaderSource(fs, 1, (const char**)&fsSource, 0);
+	glCompileShader(fs);
+
+	m_program = glCreateProgram();
+	glAttachShader(m_program, vs);
+	glAttachShader(m_program, fs);
+	glBindAttribLocation(m_program, 0, "Position");
+	glBindAttribLocation(m_program, 1, "Normal");
+	glBindAttribLocation(m_program, 2, "InstancePosition");
+	glBindAttribLocation(m_program, 3, "InstanceRotation");
+	glBindAttribLocation(m_program, 4, "InstanceScale");
+	glBindAttribLocation(m_program, 5, "InstanceColour");
+	glLinkProgram(m_program);
+
+	int success = GL_FALSE;
+	glGetProgramiv(m_program, GL_LINK_STATUS, &success);
+	if (success == GL_FALSE)
+	{
+		int infoLogLength = 0;
+		glGetProgramiv(m_program, GL_INFO_LOG_LENGTH, &infoLogLength);
+		char* infoLog = new char[infoLogLength];
+
+		glGetProgramInfoLog(m_program, infoLogLength, 0, infoLog);
+		printf("Error: Failed to link primitive shader program!\n%s\n", infoLog);
+		delete[] infoLog;
+	}
+
+	glDeleteShader(vs);
+	glDeleteShader(fs);
+
+	m_projectionViewUniform = glGetUniformLocation(m_program, "ProjectionView");
+
+	//build the unit meshes
+	std::vector<Vertex> vertices;
+	std::vector<unsigned int> indices;
+
+	buildSphere(a_rows, a_columns, false, vertices, indices);
+	buildMesh(m_meshes[SPHERE], vertices, indices);
+
+	buildBox(vertices, indices);
+	buildMesh(m_meshes[BOX], vertices, indices);
+
+	buildSphere(a_rows, a_columns, true, vertices, indices);
+	buildMesh(m_meshes[CAPSULE], vertices, indices);
+}
+
+void PrimitiveRenderer::destroy()
+{
+	for (auto& mesh : m_meshes)
+	{
+		glDeleteBuffers(1, &mesh.VBO);
+		glDeleteBuffers(1, &mesh.IBO);
+		glDeleteBuffers(1, &mesh.instanceVBO);
+		glDeleteVertexArrays(1, &mesh.VAO);
+
+		mesh.instances.clear();
+	}
+
+	glDeleteProgram(m_program);
+}
+
+void PrimitiveRenderer::clear()
+{
+	for (auto& mesh : m_meshes)
+	{
+		mesh.instances.clear();	//keeps its capacity
+		mesh.dirtyBegin = 0;
+		mesh.dirtyEnd = 0;
+	}
+}
+
+unsigned int PrimitiveRenderer::addSphere(const vec3& a_position, const glm::quat& a_rotation, float a_radius, const vec4& a_colour)
+{
+	return addInstance(SPHERE, a_position, a_rotation, vec4(a_radius, a_radius, a_radius, 0), a_colour);
+}
+
+unsigned int PrimitiveRenderer::addBox(const vec3& a_position, const glm::quat& a_rotation, const vec3& a_halfExtents, const vec4& a_colour)
+{
+	return addInstance(BOX, a_position, a_rotation, vec4(a_halfExtents, 0), a_colour);
+}
+
+unsigned int PrimitiveRenderer::addCapsule(const vec3& a_position, const glm::quat& a_rotation, float a_radius, float a_halfHeight, const vec4& a_colour)
+{
+	return addInstance(CAPSULE, a_position, a_rotation, vec4(a_radius, a_radius, a_radius, a_halfHeight), a_colour);
+}
+
+//handles are the primitive type in the top byte and the index in that type's instances below it
+unsigned int PrimitiveRenderer::addInstance(Primitive a_type, const vec3& a_position, const glm::quat& a_rotation, const vec4& a_scale, const vec4& a_colour)
+{
+	Instance instance;
+	instance.position = vec4(a_position, 1);
+	instance.rotation = vec4(a_rotation.x, a_rotation.y, a_rotation.z, a_rotation.w);
+	instance.scale = a_scale;
+	instance.colour = a_colour;
+
+	Mesh& mesh = m_meshes[a_type];
+	unsigned int index = (unsigned int)mesh.instances.size();
+
+	mesh.instances.push_back(instance);
+
+	if (mesh.dirtyBegin == mesh.dirtyEnd)
+		mesh.dirtyBegin = index;
+	mesh.dirtyEnd = index + 1;
+
+	return (a_type << 24) | index;
+}
+
+PrimitiveRenderer::Instance& PrimitiveRenderer::getInstance(unsigned int a_instance)
+{
+	Mesh& mesh = m_meshes[a_instance >> 24];
+	unsigned int index = a_instance & 0xffffff;
+
+	//widen the range to upload
+	if (mesh.dirtyBegin == mesh.dirtyEnd)
+	{
+		mesh.dirtyBegin = index;
+		mesh.dirtyEnd = index + 1;
+	}
+	else
+	{
+		mesh.dirtyBegin = glm::min(mesh.dirtyBegin, index);
+		mesh.dirtyEnd = glm::max(mesh.dirtyEnd, index + 1);
+	}
+
+	return mesh.instances[index];
+}
+
+void PrimitiveRenderer::setTransform(unsigned int a_instance, const vec3& a_position, const glm::quat& a_rotation)
+{
+	Instance& instance = getInstance(a_instance);
+
+	instance.position = vec4(a_position, instance.position.w);
+	instance.rotation = vec4(a_rotation.x, a_rotation.y, a_rotation.z, a_rotation.w);
+}
+
+void PrimitiveRenderer::setVisible(unsigned int a_instance, bool a_visible)
+{
+	getInstance(a_instance).position.w = a_visible ? 1.0f : 0.0f;
+}
+
+void PrimitiveRenderer::draw(const mat4& a_projectionView)
+{
+	PROFILE_ZONE("PrimitiveRenderer::draw");
+
+	m_drawCalls = 0;
+
+	if (getInstanceCount() == 0)
+		return;
+
+	int shader = 0;
+	glGetIntegerv(GL_CURRENT_PROGRAM, &shader);
+
+	glUseProgram(m_program);
+	glUniformMatrix4fv(m_projectionViewUniform, 1, GL_FALSE, (float*)&a_projectionView);
+
+	for (auto& mesh : m_meshes)
+	{
+		unsigned int count = (unsigned int)mesh.instances.size();
+		if (count == 0)
+			continue;
+
+		glBindBuffer(GL_ARRAY_BUFFER, mesh.instanceVBO);
+
+		//grow the instance buffer if needed, which means uploading everything again
+		if (count > mesh.instanceCapacity)
+		{
+			while (mesh.instanceCapacity < count)
+				mesh.instanceCapacity *= 2;
+
+			glBufferData(GL_ARRAY_BUFFER, mesh.instanceCapacity * sizeof(Instance), nullptr, GL_DYNAMIC_DRAW);
+			mesh.dirtyBegin = 0;
+			mesh.dirtyEnd = count;
+		}
+
+		//otherwise only what changed, nothing at all once everything is asleep
+		if (mesh.dirtyBegin < mesh.dirtyEnd)
+		{
+			glBufferSubData(GL_ARRAY_BUFFER, mesh.dirtyBegin * sizeof(Instance), (mesh.dirtyEnd - mesh.dirtyBegin) * sizeof(Instance),
+				mesh.instances.data() + mesh.dirtyBegin);
+		}
+		mesh.dirtyBegin = 0;
+		mesh.dirtyEnd = 0;
+
+		glBindVertexArray(mesh.VAO);
+		glDrawElementsInstanced(GL_TRIANGLES, mesh.indexCount, GL_UNSIGNED_INT, nullptr, count);
+
+		m_drawCalls++;
+	}
+
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	glUseProgram(shader);
+}
+
+unsigned int PrimitiveRenderer::getInstanceCount() const
+{
+	unsigned int count = 0;
+
+	for (auto& mesh : m_meshes)
+	{
+		count += (unsigned int)mesh.instances.size();
+	}
+
+	return count;
+}
+
+void PrimitiveRenderer::buildMesh(Mesh& a_mesh, const std::vector<Vertex>& a_vertices, const std::vector<unsigned int>& a_indices)
+{
+	a_mesh.indexCount = (unsigned int)a_indices.size();
+	a_mesh.instanceCapacity = 256;
+	a_mesh.instances.reserve(a_mesh.instanceCapacity);
+	a_mesh.dirtyBegin = 0;
+	a_mesh.dirtyEnd = 0;
+
+	glGenBuffers(1, &a_mesh.VBO);
+	glGenBuffers(1, &a_mesh.IBO);
+	glGenBuffers(1, &a_mesh.instanceVBO);
+
+	glGenVertexArrays(1, &a_mesh.VAO);
+	glBindVertexArray(a_mesh.VAO);
+
+	//VBO
+	glBindBuffer(GL_ARRAY_BUFFER, a_mesh.VBO);
+	glBufferData(GL_ARRAY_BUFFER, sizeof(Vertex) * a_vertices.size(), a_vertices.data(), GL_STATIC_DRAW);
+
+	glEnableVertexAttribArray(0);	//pos
+	glEnableVertexAttribArray(1);	//normal
+
+	glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, sizeof(Vertex), 0);
+	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), ((char*)0) + sizeof(vec4));
+
+	//IBO
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, a_mesh.IBO);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(unsigned int) * a_indices.size(), a_indices.data(), GL_STATIC_DRAW);
+
+	//instance data, advances once per instance rather than per vertex
+	glBindBuffer(GL_ARRAY_BUFFER, a_mesh.instanceVBO);
+	glBufferData(GL_ARRAY_BUFFER, a_mesh.instanceCapacity * sizeof(Instance), nullptr, GL_DYNAMIC_DRAW);
+
+	for (unsigned int i = 0; i < 4; i++)
+	{
+		glEnableVertexAttribArray(2 + i);
+		glVertexAttribPointer(2 + i, 4, GL_FLOAT, GL_FALSE, sizeof(Instance), ((char*)0) + sizeof(vec4) * i);
+		glVertexAttribDivisor(2 + i, 1);
+	}
+
+	//unbind
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+}
+
+void PrimitiveRenderer::buildSphere(unsigned int a_rows, unsigned int a_columns, bool a_capsule,
+									std::vector<Vertex>& a_vertices, std::vector<unsigned int>& a_indices)
+{
+	a_vertices.clear();
+	a_indices.clear();
+
+	//even number of rows so there is a ring on the equator for a capsule to split at
+	if (a_rows % 2 == 1)
+		a_rows++;
+
+	//rings run along the x axis, from -x to +x
+	unsigned int ringCount = 0;
+	for (unsigned int row = 0; row <= a_rows; ++row)
+	{
+		float latitude = (float(row) / a_rows - 0.5f) * glm::pi<float>();
+		float x = sinf(latitude);
+		float r = cosf(latitude);
+
+		//the equator is doubled for capsules, one copy for each end, which makes the cylinder
+		unsigned int copies = (a_capsule && row == a_rows / 2) ? 2 : 1;
+		for (unsigned int copy = 0; copy < copies; copy++)
+		{
+			float end = 0;
+			if (a_capsule)
+			{
+				if (row < a_rows / 2 || (row == a_rows / 2 && copy == 0))
+					end = -1;
+				else
+					end = 1;
+			}
+
+			for (unsigned int col = 0; col < a_columns; ++col)
+			{
+				float theta = float(col) / a_columns * glm::pi<float>() * 2;
+
+				Vertex vertex;
+				vertex.normal = vec3(x, r * cosf(theta), r * sinf(theta));
+				vertex.position = vec4(vertex.normal, end);
+
+				a_vertices.push_back(vertex);
+			}
+
+			ringCount++;
+		}
+	}
+
+	//join each ring to the next
+	for (unsigned int ring = 0; ring + 1 < ringCount; ++ring)
+	{
+		for (unsigned int col = 0; col < a_columns; ++col)
+		{
+			unsigned int nextCol = (col + 1) % a_columns;
+
+			unsigned int a = ring * a_columns + col;
+			unsigned int b = ring * a_columns + nextCol;
+			unsigned int c = (ring + 1) * a_columns + col;
+			unsigned int d = (ring + 1) * a_columns + nextCol;
+
+			a_indices.push_back(a);
+			a_indices.push_back(c);
+			a_indices.push_back(b);
+
+			a_indices.push_back(b);
+			a_indices.push_back(c);
+			a_indices.push_back(d);
+		}
+	}
+}
+
+void PrimitiveRenderer::buildBox(std::vector<Vertex>& a_vertices, std::vector<unsigned int>& a_indices)
+{
+	a_vertices.clear();
+	a_indices.clear();
+
+	//one face per axis direction, each with its own normal
+	for (unsigned int axis = 0; axis < 3; ++axis)
+	{
+		for (int side = -1; side <= 1; side += 2)
+		{
+			vec3 normal(0);
+			normal[axis] = (float)side;
+
+			vec3 u(0), v(0);
+			u[(axis + 1) % 3] = 1;
+			v[(axis + 2) % 3] = 1;
+
+			unsigned int first = (unsigned int)a_vertices.size();
+
+			for (unsigned int corner = 0; corner < 4; ++corner)
+			{
+				float su = (corner == 1 || corner == 2) ? 1.0f : -1.0f;
+				float sv = (corner >= 2) ? 1.0f : -1.0f;
+
+				Vertex vertex;
+				vertex.position = vec4(normal + u * su + v * sv, 0);
+				vertex.normal = normal;
+
+				a_vertices.push_back(vertex);
+			}
+
+			a_indices.push_back(first);
+			a_indices.push_back(first + 1);
+			a_indices.push_back(first + 2);
+
+			a_indices.push_back(first);
+			a_indices.push_back(first + 2);
+			a_indices.push_back(first + 3);
+		}
+	}
+}
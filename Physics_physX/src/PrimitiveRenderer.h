@@ -0,0 +1,99 @@
+#ifndef _PRIMITIVERENDERER_H_
+#define _PRIMITIVERENDERER_H_
+
+#include <vector>
+
+#include "glm_includes.h"
+
+//draws spheres, boxes and capsules from one unit mesh each on the GPU. Instances stay
+//until clear() and are moved through the handle they were added with, only instances which
+//changed since the last draw are uploaded and each primitive type is drawn with a single
+//instanced call.
+class PrimitiveRenderer
+{
+public:
+	enum Primitive
+	{
+		SPHERE,
+		BOX,
+		CAPSULE,
+		PRIMITIVE_COUNT
+	};
+
+	PrimitiveRenderer();
+	~PrimitiveRenderer();
+
+	void create(unsigned int a_rows = 12, unsigned int a_columns = 12);
+	void destroy();
+
+	//not a handle to any instance
+	static const unsigned int INVALID = 0xffffffff;
+
+	//removes all instances
+	void clear();
+
+	//boxes use half extents, capsules lie along the x axis like PhysX capsules.
+	//returns a handle for setTransform and setVisible
+	unsigned int addSphere(const vec3& a_position, const glm::quat& a_rotation, float a_radius, const vec4& a_colour);
+	unsigned int addBox(const vec3& a_position, const glm::quat& a_rotation, const vec3& a_halfExtents, const vec4& a_colour);
+	unsigned int addCapsule(const vec3& a_position, const glm::quat& a_rotation, float a_radius, float a_halfHeight, const vec4& a_colour);
+
+	void setTransform(unsigned int a_instance, const vec3& a_position, const glm::quat& a_rotation);
+
+	//hidden instances are still drawn, but collapsed to a point
+	void setVisible(unsigned int a_instance, bool a_visible);
+
+	void draw(const mat4& a_projectionView);
+
+	unsigned int getInstanceCount() const;
+	unsigned int getDrawCallCount() const { return m_drawCalls; }
+
+private:
+	struct Vertex
+	{
+		vec4 position;	//w says which end of a capsule the vertex belongs to (-1, 0 or 1)
+		vec3 normal;
+	};
+
+	struct Instance
+	{
+		vec4 position;	//w is 0 when hidden
+		vec4 rotation;	//quaternion as x, y, z, w
+		vec4 scale;		//xyz scale the unit mesh, w is the capsule half height
+		vec4 colour;
+	};
+
+	struct Mesh
+	{
+		unsigned int VAO;
+		unsigned int VBO;
+		unsigned int IBO;
+		unsigned int indexCount;
+
+		unsigned int instanceVBO;
+		unsigned int instanceCapacity;	//size of instanceVBO in instances
+		std::vector<Instance> instances;
+
+		//instances changed since the last upload
+		unsigned int dirtyBegin;
+		unsigned int dirtyEnd;
+	};
+
+	Instance& getInstance(unsigned int a_instance);
+
+	unsigned int addInstance(Primitive a_type, const vec3& a_position, const glm::quat& a_rotation, const vec4& a_scale, const vec4& a_colour);
+
+	void buildMesh(Mesh& a_mesh, const std::vector<Vertex>& a_vertices, const std::vector<unsigned int>& a_indices);
+	void buildSphere(unsigned int a_rows, unsigned int a_columns, bool a_capsule,
+					 std::vector<Vertex>& a_vertices, std::vector<unsigned int>& a_indices);
+	void buildBox(std::vector<Vertex>& a_vertices, std::vector<unsigned int>& a_indices);
+
+	unsigned int m_program;
+	int m_projectionViewUniform;
+
+	Mesh m_meshes[PRIMITIVE_COUNT];
+
+	unsigned int m_drawCalls;
+};
+
+#endif // !_PRIMITIVERENDERER_H_
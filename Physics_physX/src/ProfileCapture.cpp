@@ -0,0 +1,329 @@
+#include "ProfileCapture.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <string>
+#include <vector>
+
+static const char CaptureMagic[8] = { 'P', 'X', 'P', 'R', 'O', 'F', '1', 0 };
+
+//hands the PVD connection a file which closes itself once it reaches the size limit
+class BoundedPvdFileStream : public debugger::PvdNetworkOutStream
+{
+public:
+	BoundedPvdFileStream(FILE* a_file, size_t a_maxBytes) : m_file(a_file), m_written(0), m_maxBytes(a_maxBytes) {}
+
+	virtual debugger::PvdError write(const PxU8* a_bytes, PxU32 a_length)
+	{
+		if (m_file == nullptr)
+			return debugger::PvdErrorType::NetworkError;
+
+		//full, look like a dropped connection so PhysX stops sending
+		if (m_written + a_length > m_maxBytes)
+		{
+			printf("PVD capture reached its %u KB limit\n", (unsigned int)(m_maxBytes / 1024));
+			disconnect();
+			return debugger::PvdErrorType::NetworkError;
+		}
+
+		fwrite(a_bytes, 1, a_length, m_file);
+		m_written += a_length;
+
+		return debugger::PvdErrorType::Success;
+	}
+
+	virtual bool isConnected() const { return m_file != nullptr; }
+
+	virtual void disconnect()
+	{
+		if (m_file != nullptr)
+			fclose(m_file);
+		m_file = nullptr;
+	}
+
+	virtual void release()
+	{
+		disconnect();
+		delete this;
+	}
+
+	virtual debugger::PvdError flush()
+	{
+		if (m_file != nullptr)
+			fflush(m_file);
+		return debugger::PvdErrorType::Success;
+	}
+
+	virtual PxU64 getWrittenDataSize() { return m_written; }
+
+private:
+	FILE* m_file;
+	size_t m_written;
+	size_t m_maxBytes;
+};
+
+ProfileCapture::ProfileCapture() : m_file(nullptr), m_written(0), m_maxBytes(0), m_dropped(0) {}
+
+ProfileCapture::~ProfileCapture()
+{
+	close();
+}
+
+bool ProfileCapture::open(const char* a_filename, size_t a_maxBytes)
+{
+	close();
+
+	m_file = fopen(a_filename, "wb");
+	if (m_file == nullptr)
+	{
+		printf("Error: Failed to open %s for writing\n", a_filename);
+		return false;
+	}
+
+	fwrite(CaptureMagic, 1, sizeof(CaptureMagic), m_file);
+
+	m_written = sizeof(CaptureMagic);
+	m_maxBytes = a_maxBytes;
+	m_dropped = 0;
+	m_nameIds.clear();
+
+	return true;
+}
+
+void ProfileCapture::close()
+{
+	if (m_file == nullptr)
+		return;
+
+	fclose(m_file);
+	m_file = nullptr;
+
+	printf("Profile capture: %u KB written", (unsigned int)(m_written / 1024));
+	if (m_dropped > 0)
+		printf(", %u events dropped at the size limit", m_dropped);
+	printf("\n");
+}
+
+bool ProfileCapture::connectPvd(PxVisualDebuggerConnectionManager* a_manager, const char* a_filename, size_t a_maxBytes,
+								PxVisualDebuggerConnectionFlags a_flags)
+{
+	if (a_manager == nullptr)
+		return false;
+
+	FILE* file = fopen(a_filename, "wb");
+	if (file == nullptr)
+	{
+		printf("Error: Failed to open %s for writing\n", a_filename);
+		return false;
+	}
+
+	//the connection releases the stream when it disconnects
+	BoundedPvdFileStream* stream = new BoundedPvdFileStream(file, a_maxBytes);
+	//the two flag types share their bit values
+	a_manager->connect(nullptr, *stream, debugger::TConnectionFlagsType(PxU32(a_flags)));
+
+	return true;
+}
+
+bool ProfileCapture::writeName(const char* a_name, unsigned short& a_id)
+{
+	auto found = m_nameIds.find(a_name);
+	if (found != m_nameIds.end())
+	{
+		a_id = found->second;
+		return true;
+	}
+
+	unsigned short length = (unsigned short)strlen(a_name);
+	size_t size = 1 + sizeof(unsigned short) * 2 + length;
+
+	if (m_written + size > m_maxBytes || m_nameIds.size() == 0xffff)
+		return false;
+
+	a_id = (unsigned short)m_nameIds.size();
+	m_nameIds[a_name] = a_id;
+
+	char type = RECORD_NAME;
+	fwrite(&type, 1, 1, m_file);
+	fwrite(&a_id, sizeof(a_id), 1, m_file);
+	fwrite(&length, sizeof(length), 1, m_file);
+	fwrite(a_name, 1, length, m_file);
+	m_written += size;
+
+	return true;
+}
+
+void ProfileCapture::onEvent(const PxBufferedProfilerEvent& a_event)
+{
+	std::lock_guard<std::mutex> lock(m_lock);
+
+	if (m_file == nullptr)
+		return;
+
+	const size_t eventSize = 1 + sizeof(unsigned short) + sizeof(PxU32) + sizeof(PxU64) * 2;
+
+	unsigned short id = 0;
+	if (writeName(a_event.name != nullptr ? a_event.name : "unnamed", id) == false || m_written + eventSize > m_maxBytes)
+	{
+		m_dropped++;
+		return;
+	}
+
+	char type = RECORD_EVENT;
+	PxU32 thread = a_event.threadId;
+	PxU64 start = a_event.startTimeNs;
+	PxU64 stop = a_event.stopTimeNs;
+
+	fwrite(&type, 1, 1, m_file);
+	fwrite(&id, sizeof(id), 1, m_file);
+	fwrite(&thread, sizeof(thread), 1, m_file);
+	fwrite(&start, sizeof(start), 1, m_file);
+	fwrite(&stop, sizeof(stop), 1, m_file);
+	m_written += eventSize;
+}
+
+//summary
+
+namespace
+{
+	struct EventStats
+	{
+		std::string name;
+		unsigned int count;
+		double totalMs;
+		double maxMs;
+	};
+
+	const char* stageOf(const std::string& a_name)
+	{
+		std::string name = a_name;
+		std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+
+		if (name.find("broadphase") != std::string::npos || name.find("aabb") != std::string::npos)
+			return "broadphase";
+		if (name.find("narrowphase") != std::string::npos || name.find("contact") != std::string::npos)
+			return "narrowphase";
+		if (name.find("solve") != std::string::npos || name.find("constraint") != std::string::npos ||
+			name.find("integrat") != std::string::npos)
+			return "solver";
+		if (name.find("island") != std::string::npos)
+			return "islands";
+
+		return "other";
+	}
+}
+
+bool ProfileCapture::summarise(const char* a_filename)
+{
+	FILE* file = fopen(a_filename, "rb");
+	if (file == nullptr)
+	{
+		printf("Error: Failed to open %s\n", a_filename);
+		return false;
+	}
+
+	char magic[sizeof(CaptureMagic)];
+	if (fread(magic, 1, sizeof(magic), file) != sizeof(magic) || memcmp(magic, CaptureMagic, sizeof(magic)) != 0)
+	{
+		printf("Error: %s isn't a profile capture\n", a_filename);
+		fclose(file);
+		return false;
+	}
+
+	std::vector<EventStats> events;
+	PxU64 firstStart = ~0ull;
+	PxU64 lastStop = 0;
+	unsigned int eventCount = 0;
+
+	char type = 0;
+	while (fread(&type, 1, 1, file) == 1)
+	{
+		if (type == RECORD_NAME)
+		{
+			unsigned short id = 0, length = 0;
+			if (fread(&id, sizeof(id), 1, file) != 1 || fread(&length, sizeof(length), 1, file) != 1)
+				break;
+
+			std::string name(length, ' ');
+			if (length > 0 && fread(&name[0], 1, length, file) != length)
+				break;
+
+			if (id >= events.size())
+				events.resize(id + 1);
+
+			events[id].name = name;
+			events[id].count = 0;
+			events[id].totalMs = 0;
+			events[id].maxMs = 0;
+		}
+		else if (type == RECORD_EVENT)
+		{
+			unsigned short id = 0;
+			PxU32 thread = 0;
+			PxU64 start = 0, stop = 0;
+			if (fread(&id, sizeof(id), 1, file) != 1 || fread(&thread, sizeof(thread), 1, file) != 1 ||
+				fread(&start, sizeof(start), 1, file) != 1 || fread(&stop, sizeof(stop), 1, file) != 1)
+				break;
+
+			if (id >= events.size() || stop < start)
+				continue;
+
+			double ms = (stop - start) / 1000000.0;
+
+			EventStats& stats = events[id];
+			stats.count++;
+			stats.totalMs += ms;
+			stats.maxMs = std::max(stats.maxMs, ms);
+
+			firstStart = std::min(firstStart, start);
+			lastStop = std::max(lastStop, stop);
+			eventCount++;
+		}
+		else
+		{
+			printf("Warning: %s is corrupt, stopping early\n", a_filename);
+			break;
+		}
+	}
+
+	fclose(file);
+
+	if (eventCount == 0)
+	{
+		printf("%s has no events (PhysX only sends them from debug, checked and profile builds)\n", a_filename);
+		return true;
+	}
+
+	std::sort(events.begin(), events.end(), [](const EventStats& a, const EventStats& b) { return a.totalMs > b.totalMs; });
+
+	printf("%u events over %.2fms\n\n", eventCount, (lastStop - firstStart) / 1000000.0);
+
+	//per stage
+	const char* stages[] = { "broadphase", "narrowphase", "solver", "islands", "other" };
+
+	printf("%-16s %12s\n", "stage", "total ms");
+	for (auto stage : stages)
+	{
+		double total = 0;
+		for (auto& stats : events)
+		{
+			if (stats.count > 0 && strcmp(stageOf(stats.name), stage) == 0)
+				total += stats.totalMs;
+		}
+		printf("%-16s %12.3f\n", stage, total);
+	}
+
+	//per event
+	printf("\n%-48s %-12s %8s %12s %10s %10s\n", "event", "stage", "count", "total ms", "mean ms", "max ms");
+	for (auto& stats : events)
+	{
+		if (stats.count == 0)
+			continue;
+
+		printf("%-48s %-12s %8u %12.3f %10.4f %10.4f\n", stats.name.c_str(), stageOf(stats.name),
+			stats.count, stats.totalMs, stats.totalMs / stats.count, stats.maxMs);
+	}
+
+	return true;
+}
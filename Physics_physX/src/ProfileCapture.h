@@ -0,0 +1,56 @@
+#ifndef _PROFILECAPTURE_H_
+#define _PROFILECAPTURE_H_
+
+#include <PxPhysicsAPI.h>
+
+#include <cstdio>
+#include <mutex>
+#include <unordered_map>
+
+using namespace physx;
+
+//records PhysX profile zone events to a file so runs can be profiled without PVD listening,
+//and streams the PVD connection to a second file which PVD can open later. both files stop
+//growing once they reach their size limit.
+//PhysX only sends profile events from its debug, checked and profile builds.
+class ProfileCapture : public PxBufferedProfilerCallback
+{
+public:
+	ProfileCapture();
+	~ProfileCapture();
+
+	//starts writing events to a_filename
+	bool open(const char* a_filename, size_t a_maxBytes);
+	void close();
+
+	bool isOpen() const { return m_file != nullptr; }
+
+	//connects PVD to a size limited file instead of a socket
+	static bool connectPvd(PxVisualDebuggerConnectionManager* a_manager, const char* a_filename, size_t a_maxBytes,
+						   PxVisualDebuggerConnectionFlags a_flags);
+
+	//prints per event and per stage (solver, broadphase, narrowphase...) timings from a capture
+	static bool summarise(const char* a_filename);
+
+	virtual void onEvent(const PxBufferedProfilerEvent& a_event);
+
+private:
+	//on disk every record starts with its type
+	enum RecordType
+	{
+		RECORD_NAME = 'N',		//u16 id, u16 length, then the name
+		RECORD_EVENT = 'E'		//u16 name id, u32 thread, u64 start ns, u64 stop ns
+	};
+
+	bool writeName(const char* a_name, unsigned short& a_id);
+
+	FILE* m_file;
+	size_t m_written;
+	size_t m_maxBytes;
+	unsigned int m_dropped;
+
+	std::mutex m_lock;	//events arrive from whichever thread flushed a buffer
+	std::unordered_map<const char*, unsigned short> m_nameIds;
+};
+
+#endif // !_PROFILECAPTURE_H_
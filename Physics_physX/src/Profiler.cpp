@@ -0,0 +1,436 @@
+#include "Profiler.h"
+
+#include "gl_core_4_4.h"
+#include "glm_includes.h"
+#include "Gizmos.h"
+
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <vector>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#define PROFILER_THREAD_LOCAL __declspec(thread)
+#else
+#include <chrono>
+#define PROFILER_THREAD_LOCAL __thread
+#endif
+
+bool Profiler::sm_enabled = false;
+
+namespace
+{
+	struct ZoneEvent
+	{
+		const char* name;
+		unsigned long long start;
+		unsigned long long end;
+	};
+
+	//per thread, oldest events are overwritten once it wraps
+	const unsigned int RING_SIZE = 1 << 15;
+
+	struct ThreadBuffer
+	{
+		ZoneEvent events[RING_SIZE];
+		std::atomic<unsigned int> head;		//total events written, only the owning thread writes
+		unsigned int summaryCursor;			//events up to here are in the averages
+		unsigned int id;
+		const char* name;
+	};
+
+	//GPU queries are read back GPU_FRAMES frames later so we never wait on them
+	const unsigned int GPU_FRAMES = 3;
+	const unsigned int GPU_QUERIES = 16;	//per frame
+
+	struct GpuQuery
+	{
+		unsigned int query;
+		const char* name;
+		unsigned long long cpuStart;
+	};
+
+	struct SummaryRow
+	{
+		const char* name;
+		bool gpu;
+		double frameTime;	//ms so far this frame
+		double average;		//rolling ms per frame
+	};
+
+	const unsigned int MAX_ROWS = 32;
+
+	struct ProfilerData
+	{
+		std::mutex lock;
+		std::vector<ThreadBuffer*> buffers;
+		ThreadBuffer* gpuBuffer;			//finished GPU queries, written by newFrame
+
+		unsigned long long startTicks;
+		double ticksPerMs;
+
+		GpuQuery queries[GPU_FRAMES][GPU_QUERIES];
+		unsigned int queryCount[GPU_FRAMES];
+		unsigned int gpuFrame;
+		bool gpuZoneOpen;
+		bool queriesCreated;
+
+		SummaryRow rows[MAX_ROWS];
+		unsigned int rowCount;
+	};
+
+	ProfilerData* s_data = nullptr;
+	unsigned int s_generation = 0;	//bumped by create so threads don't keep buffers from an old profiler
+
+	PROFILER_THREAD_LOCAL ThreadBuffer* s_threadBuffer = nullptr;
+	PROFILER_THREAD_LOCAL unsigned int s_threadGeneration = 0;
+	PROFILER_THREAD_LOCAL const char* s_threadName = nullptr;
+
+	ThreadBuffer* createBuffer(const char* a_name)
+	{
+		ThreadBuffer* buffer = new ThreadBuffer();
+		buffer->head = 0;
+		buffer->summaryCursor = 0;
+		buffer->id = (unsigned int)s_data->buffers.size();
+		buffer->name = a_name;
+
+		s_data->buffers.push_back(buffer);
+		return buffer;
+	}
+
+	//buffers are made the first time a thread records something
+	ThreadBuffer* getThreadBuffer()
+	{
+		if (s_threadBuffer == nullptr || s_threadGeneration != s_generation)
+		{
+			std::lock_guard<std::mutex> lock(s_data->lock);
+
+			s_threadBuffer = createBuffer(s_threadName);
+			s_threadGeneration = s_generation;
+		}
+
+		return s_threadBuffer;
+	}
+
+	void writeEvent(ThreadBuffer* a_buffer, const char* a_name, unsigned long long a_start, unsigned long long a_end)
+	{
+		unsigned int head = a_buffer->head.load(std::memory_order_relaxed);
+
+		ZoneEvent& event = a_buffer->events[head % RING_SIZE];
+		event.name = a_name;
+		event.start = a_start;
+		event.end = a_end;
+
+		a_buffer->head.store(head + 1, std::memory_order_release);
+	}
+
+	SummaryRow* findRow(const char* a_name, bool a_gpu)
+	{
+		for (unsigned int i = 0; i < s_data->rowCount; i++)
+		{
+			SummaryRow& row = s_data->rows[i];
+			if (row.gpu == a_gpu && (row.name == a_name || strcmp(row.name, a_name) == 0))
+				return &row;
+		}
+
+		if (s_data->rowCount == MAX_ROWS)
+			return nullptr;
+
+		SummaryRow& row = s_data->rows[s_data->rowCount++];
+		row.name = a_name;
+		row.gpu = a_gpu;
+		row.frameTime = 0;
+		row.average = 0;
+
+		return &row;
+	}
+
+	//first event still in the ring
+	unsigned int firstEvent(unsigned int a_head, unsigned int a_cursor)
+	{
+		if (a_head - a_cursor > RING_SIZE)
+			return a_head - RING_SIZE;
+
+		return a_cursor;
+	}
+}
+
+void Profiler::create()
+{
+	if (s_data != nullptr)
+		return;
+
+	s_data = new ProfilerData();
+	s_generation++;
+
+#ifdef _WIN32
+	LARGE_INTEGER frequency;
+	QueryPerformanceFrequency(&frequency);
+	s_data->ticksPerMs = frequency.QuadPart / 1000.0;
+#else
+	s_data->ticksPerMs = 1000000.0;
+#endif
+	s_data->startTicks = getTicks();
+
+	s_data->gpuBuffer = createBuffer("GPU");
+	s_data->gpuFrame = 0;
+	s_data->gpuZoneOpen = false;
+	s_data->queriesCreated = false;
+	for (auto& count : s_data->queryCount)
+		count = 0;
+
+	s_data->rowCount = 0;
+}
+
+void Profiler::destroy()
+{
+	if (s_data == nullptr)
+		return;
+
+	sm_enabled = false;
+
+	if (s_data->queriesCreated)
+	{
+		for (auto& frame : s_data->queries)
+		{
+			for (auto& query : frame)
+				glDeleteQueries(1, &query.query);
+		}
+	}
+
+	for (auto buffer : s_data->buffers)
+		delete buffer;
+
+	delete s_data;
+	s_data = nullptr;
+}
+
+void Profiler::setEnabled(bool a_enabled)
+{
+	sm_enabled = a_enabled && s_data != nullptr;
+}
+
+void Profiler::setThreadName(const char* a_name)
+{
+	s_threadName = a_name;
+
+	if (s_data != nullptr && s_threadBuffer != nullptr && s_threadGeneration == s_generation)
+		s_threadBuffer->name = a_name;
+}
+
+unsigned long long Profiler::getTicks()
+{
+#ifdef _WIN32
+	LARGE_INTEGER ticks;
+	QueryPerformanceCounter(&ticks);
+	return ticks.QuadPart;
+#else
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+unsigned long long Profiler::beginZone()
+{
+	return getTicks();
+}
+
+void Profiler::endZone(const char* a_name, unsigned long long a_start)
+{
+	if (s_data == nullptr)
+		return;
+
+	writeEvent(getThreadBuffer(), a_name, a_start, getTicks());
+}
+
+bool Profiler::beginGpuZone(const char* a_name)
+{
+	if (s_data == nullptr || s_data->gpuZoneOpen)
+		return false;
+
+	//made on first use so headless runs never touch GL
+	if (s_data->queriesCreated == false)
+	{
+		for (auto& frame : s_data->queries)
+		{
+			for (auto& query : frame)
+				glGenQueries(1, &query.query);
+		}
+		s_data->queriesCreated = true;
+	}
+
+	unsigned int& count = s_data->queryCount[s_data->gpuFrame];
+	if (count == GPU_QUERIES)
+		return false;
+
+	GpuQuery& query = s_data->queries[s_data->gpuFrame][count++];
+	query.name = a_name;
+	query.cpuStart = getTicks();
+
+	glBeginQuery(GL_TIME_ELAPSED, query.query);
+	s_data->gpuZoneOpen = true;
+
+	return true;
+}
+
+void Profiler::endGpuZone()
+{
+	if (s_data == nullptr || s_data->gpuZoneOpen == false)
+		return;
+
+	glEndQuery(GL_TIME_ELAPSED);
+	s_data->gpuZoneOpen = false;
+}
+
+void Profiler::newFrame()
+{
+	if (s_data == nullptr)
+		return;
+
+	//collect the GPU queries from GPU_FRAMES ago, before their slots are reused
+	s_data->gpuFrame = (s_data->gpuFrame + 1) % GPU_FRAMES;
+
+	unsigned int& count = s_data->queryCount[s_data->gpuFrame];
+	for (unsigned int i = 0; i < count; i++)
+	{
+		GpuQuery& query = s_data->queries[s_data->gpuFrame][i];
+
+		GLuint available = GL_FALSE;
+		glGetQueryObjectuiv(query.query, GL_QUERY_RESULT_AVAILABLE, &available);
+		if (available == GL_FALSE)
+			continue;	//very late, drop it rather than stall
+
+		GLuint64 nanoseconds = 0;
+		glGetQueryObjectui64v(query.query, GL_QUERY_RESULT, &nanoseconds);
+
+		//placed on the timeline where the CPU issued it
+		unsigned long long duration = (unsigned long long)(nanoseconds / 1000000.0 * s_data->ticksPerMs);
+		writeEvent(s_data->gpuBuffer, query.name, query.cpuStart, query.cpuStart + duration);
+	}
+	count = 0;
+
+	//add up each zone's time since the last frame
+	std::lock_guard<std::mutex> lock(s_data->lock);
+
+	for (auto buffer : s_data->buffers)
+	{
+		unsigned int head = buffer->head.load(std::memory_order_acquire);
+
+		for (unsigned int i = firstEvent(head, buffer->summaryCursor); i != head; i++)
+		{
+			const ZoneEvent& event = buffer->events[i % RING_SIZE];
+
+			SummaryRow* row = findRow(event.name, buffer == s_data->gpuBuffer);
+			if (row != nullptr)
+				row->frameTime += (event.end - event.start) / s_data->ticksPerMs;
+		}
+
+		buffer->summaryCursor = head;
+	}
+
+	for (unsigned int i = 0; i < s_data->rowCount; i++)
+	{
+		SummaryRow& row = s_data->rows[i];
+		row.average = row.average * 0.9 + row.frameTime * 0.1;
+		row.frameTime = 0;
+	}
+}
+
+bool Profiler::writeTrace(const char* a_filename)
+{
+	if (s_data == nullptr)
+		return false;
+
+	FILE* file = fopen(a_filename, "w");
+	if (file == nullptr)
+	{
+		printf("Error: Failed to open %s for writing\n", a_filename);
+		return false;
+	}
+
+	std::lock_guard<std::mutex> lock(s_data->lock);
+
+	fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+
+	bool first = true;
+
+	for (auto buffer : s_data->buffers)
+	{
+		const char* name = buffer->name != nullptr ? buffer->name : "Thread";
+
+		fprintf(file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"%s %u\"}}",
+			first ? "" : ",\n", buffer->id, name, buffer->id);
+		first = false;
+
+		unsigned int head = buffer->head.load(std::memory_order_acquire);
+
+		for (unsigned int i = firstEvent(head, 0); i != head; i++)
+		{
+			const ZoneEvent& event = buffer->events[i % RING_SIZE];
+
+			//microseconds from when the profiler was created
+			double start = (event.start - s_data->startTicks) / s_data->ticksPerMs * 1000.0;
+			double duration = (event.end - event.start) / s_data->ticksPerMs * 1000.0;
+
+			fprintf(file, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+				event.name, buffer->id, start, duration);
+		}
+	}
+
+	fprintf(file, "\n]}\n");
+	fclose(file);
+
+	return true;
+}
+
+void Profiler::addOverlay(const glm::vec2& a_topLeft)
+{
+	if (s_data == nullptr || sm_enabled == false || s_data->rowCount == 0)
+		return;
+
+	const float pixelsPerMs = 10.0f;
+	const float rowHeight = 10.0f;
+	const float width = pixelsPerMs * 35.0f;
+	float height = rowHeight * s_data->rowCount;
+
+	//background
+	Gizmos::add2DAABBFilled(a_topLeft + vec2(width, -height) * 0.5f, vec2(width, height) * 0.5f, vec4(0, 0, 0, 0.5f));
+
+	const vec4 cpuColours[] = { vec4(1, 0.5f, 0, 1), vec4(1, 0.8f, 0, 1), vec4(0.6f, 1, 0, 1), vec4(0, 1, 0.6f, 1) };
+	const vec4 gpuColours[] = { vec4(0.3f, 0.5f, 1, 1), vec4(0.7f, 0.4f, 1, 1) };
+
+	for (unsigned int i = 0; i < s_data->rowCount; i++)
+	{
+		const SummaryRow& row = s_data->rows[i];
+
+		float barWidth = glm::min((float)row.average * pixelsPerMs, width);
+		vec2 centre = a_topLeft + vec2(barWidth * 0.5f, -(i + 0.5f) * rowHeight);
+
+		vec4 colour = row.gpu ? gpuColours[i % 2] : cpuColours[i % 4];
+
+		Gizmos::add2DAABBFilled(centre, vec2(barWidth * 0.5f, rowHeight * 0.4f), colour);
+	}
+
+	//marks for a 60Hz and 30Hz frame
+	float frame60 = pixelsPerMs * 1000.0f / 60.0f;
+	float frame30 = pixelsPerMs * 1000.0f / 30.0f;
+	Gizmos::add2DLine(a_topLeft + vec2(frame60, 0), a_topLeft + vec2(frame60, -height), vec4(1));
+	Gizmos::add2DLine(a_topLeft + vec2(frame30, 0), a_topLeft + vec2(frame30, -height), vec4(1, 0, 0, 1));
+}
+
+void Profiler::printSummary()
+{
+	if (s_data == nullptr)
+		return;
+
+	printf("%-32s %4s %10s\n", "zone", "", "avg ms");
+
+	for (unsigned int i = 0; i < s_data->rowCount; i++)
+	{
+		const SummaryRow& row = s_data->rows[i];
+		printf("%-32s %4s %10.4f\n", row.name, row.gpu ? "GPU" : "CPU", row.average);
+	}
+}
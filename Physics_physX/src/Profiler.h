@@ -0,0 +1,100 @@
+#ifndef _PROFILER_H_
+#define _PROFILER_H_
+
+#include <glm/fwd.hpp>
+
+//scoped CPU zones are recorded into a ring buffer per thread and GPU passes are timed with
+//GL_TIME_ELAPSED queries. the results can be written out as a Chrome trace (chrome://tracing
+//or Perfetto) and a rolling average of each zone drawn as bars with Gizmos.
+//when disabled a zone costs one branch, define DISABLE_PROFILER to compile them out entirely.
+class Profiler
+{
+public:
+
+	static void		create();
+	static void		destroy();
+
+	static void		setEnabled(bool a_enabled);
+	static bool		isEnabled() { return sm_enabled; }
+
+	// marks the start of a new frame, collects finished GPU queries and updates the averages
+	static void		newFrame();
+
+	// shows up as the thread's name in the trace, a_name must outlive the profiler
+	static void		setThreadName(const char* a_name);
+
+	// used by ProfileZone and ProfileGpuZone
+	static unsigned long long	beginZone();
+	static void		endZone(const char* a_name, unsigned long long a_start);
+	static bool		beginGpuZone(const char* a_name);	// false if another GPU zone is open
+	static void		endGpuZone();
+
+	// writes everything still in the ring buffers as Chrome trace JSON
+	static bool		writeTrace(const char* a_filename);
+
+	// adds a bar per zone, rolling average in ms, below and to the right of a_topLeft
+	static void		addOverlay(const glm::vec2& a_topLeft);
+
+	// prints the rolling averages
+	static void		printSummary();
+
+	static unsigned long long	getTicks();
+
+private:
+
+	static bool		sm_enabled;
+};
+
+//times the enclosing scope
+class ProfileZone
+{
+public:
+	ProfileZone(const char* a_name) : m_name(a_name), m_start(0)
+	{
+		if (Profiler::isEnabled())
+			m_start = Profiler::beginZone();
+	}
+
+	~ProfileZone()
+	{
+		if (m_start != 0)
+			Profiler::endZone(m_name, m_start);
+	}
+
+private:
+	const char* m_name;
+	unsigned long long m_start;
+};
+
+//times the GL commands issued in the enclosing scope, these can't be nested
+class ProfileGpuZone
+{
+public:
+	ProfileGpuZone(const char* a_name) : m_active(false)
+	{
+		if (Profiler::isEnabled())
+			m_active = Profiler::beginGpuZone(a_name);
+	}
+
+	~ProfileGpuZone()
+	{
+		if (m_active)
+			Profiler::endGpuZone();
+	}
+
+private:
+	bool m_active;
+};
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+
+#ifndef DISABLE_PROFILER
+#define PROFILE_ZONE(name) ProfileZone PROFILE_CONCAT(profileZone, __LINE__)(name)
+#define PROFILE_GPU_ZONE(name) ProfileGpuZone PROFILE_CONCAT(profileGpuZone, __LINE__)(name)
+#else
+#define PROFILE_ZONE(name)
+#define PROFILE_GPU_ZONE(name)
+#endif
+
+#endif // !_PROFILER_H_
@@ -0,0 +1,147 @@
+#include "ProjectilePool.h"
+
+#include "PhysicsDemoScene.h"
+
+ProjectilePool::ProjectilePool()
+	: m_killVolume(PxVec3(-500.0f), PxVec3(500.0f)),
+	m_app(nullptr),
+	m_capacity(0),
+	m_activeCount(0),
+	m_spawnCount(0),
+	m_radius(0),
+	m_density(0)
+{}
+ProjectilePool::~ProjectilePool() {}
+
+void ProjectilePool::create(PhysicsDemoScene* a_app, unsigned int a_capacity, float a_radius, float a_density)
+{
+	m_app = a_app;
+	m_capacity = a_capacity > 0 ? a_capacity : 1;
+	m_radius = a_radius;
+	m_density = a_density;
+
+	//actors are created as they are needed, but never more than this
+	m_projectiles.reserve(m_capacity);
+}
+
+PxRigidDynamic* ProjectilePool::spawn(const PxVec3& a_position, const PxVec3& a_velocity)
+{
+	PxTransform transform(a_position);
+
+	unsigned int slot = findSlot();
+
+	//pool isn't full yet, make a new actor
+	if (slot == m_projectiles.size())
+	{
+		PxSphereGeometry projectile(m_radius);
+
+		Projectile p;
+		p.actor = PxCreateDynamic(*m_app->g_Physics, transform, projectile, *m_app->g_PhysicsMaterial, m_density);
+
+		//lets aiming see past projectiles in flight, and have their impacts reported
+		PxShape* shape;
+		p.actor->getShapes(&shape, 1);
+		shape->setQueryFilterData(PxFilterData(SceneQueries::GROUP_PROJECTILE, 0, 0, 0));
+		shape->setSimulationFilterData(PxFilterData(SimulationEvents::REPORT_CONTACTS, 0, 0, 0));
+		p.actorIndex = (unsigned int)m_app->g_PhysXActors.size();
+		p.active = false;
+
+		m_app->g_PhysXActors.push_back(p.actor);
+		m_projectiles.push_back(p);
+	}
+
+	Projectile& p = m_projectiles[slot];
+
+	p.actor->setGlobalPose(transform);
+
+	//put it back in the scene if it was retired
+	if (p.active == false)
+	{
+		m_app->g_PhysicsScene->addActor(*p.actor);
+
+		p.active = true;
+		m_activeCount++;
+	}
+
+	//reset motion
+	p.actor->setLinearVelocity(a_velocity, true);
+	p.actor->setAngularVelocity(PxVec3(0), false);
+
+	//don't blend from wherever it was before
+	m_app->m_renderState.setPose(p.actorIndex, transform);
+	m_app->m_renderState.setEnabled(p.actorIndex, true);
+
+	p.spawnNumber = m_spawnCount++;
+
+	return p.actor;
+}
+
+void ProjectilePool::update()
+{
+	for (auto& p : m_projectiles)
+	{
+		if (p.active == false || p.actorIndex >= m_app->m_renderState.getBodyCount())
+			continue;
+
+		if (m_killVolume.contains(m_app->m_renderState.m_positions[p.actorIndex]) == false)
+		{
+			retire(p);
+		}
+	}
+}
+
+bool ProjectilePool::retire(PxRigidActor* a_actor)
+{
+	for (auto& p : m_projectiles)
+	{
+		if (p.actor != a_actor)
+			continue;
+
+		if (p.active)
+			retire(p);
+		return true;
+	}
+
+	return false;
+}
+
+unsigned int ProjectilePool::findSlot()
+{
+	unsigned int sleeping = (unsigned int)m_projectiles.size();
+	unsigned int oldest = 0;
+
+	for (unsigned int i = 0; i < m_projectiles.size(); i++)
+	{
+		Projectile& p = m_projectiles[i];
+
+		//retired ones are free
+		if (p.active == false)
+			return i;
+
+		if (p.actor->isSleeping() && sleeping == m_projectiles.size())
+			sleeping = i;
+
+		if (p.spawnNumber < m_projectiles[oldest].spawnNumber)
+			oldest = i;
+	}
+
+	//still room for a new one
+	if (m_projectiles.size() < m_capacity)
+		return (unsigned int)m_projectiles.size();
+
+	//otherwise take one that has come to rest, or the oldest
+	if (sleeping < m_projectiles.size())
+		return sleeping;
+
+	return oldest;
+}
+
+void ProjectilePool::retire(Projectile& a_projectile)
+{
+	m_app->g_PhysicsScene->removeActor(*a_projectile.actor);
+
+	m_app->m_renderState.setEnabled(a_projectile.actorIndex, false);
+
+	a_projectile.active = false;
+	m_activeCount--;
+}
@@ -0,0 +1,59 @@
+#ifndef _PROJECTILEPOOL_H_
+#define _PROJECTILEPOOL_H_
+
+#include <PxPhysicsAPI.h>
+
+#include <vector>
+
+using namespace physx;
+
+class PhysicsDemoScene;
+
+//fixed number of projectile actors which get recycled instead of creating a new one per shot
+class ProjectilePool
+{
+public:
+	ProjectilePool();
+	~ProjectilePool();
+
+	void create(PhysicsDemoScene* a_app, unsigned int a_capacity, float a_radius, float a_density);
+
+	//fire a projectile, reusing a retired, sleeping or the oldest one once the pool is full
+	PxRigidDynamic* spawn(const PxVec3& a_position, const PxVec3& a_velocity);
+
+	//retire any projectiles which have left the kill volume
+	void update();
+
+	//retire a_actor now if it is one of ours, false if it isn't
+	bool retire(PxRigidActor* a_actor);
+
+	unsigned int getActiveCount() const { return m_activeCount; }
+
+public:
+	//anything outside this is taken out of the scene
+	PxBounds3 m_killVolume;
+
+private:
+	struct Projectile
+	{
+		PxRigidDynamic* actor;
+		unsigned int actorIndex;	//index into PhysicsDemoScene::g_PhysXActors
+		unsigned int spawnNumber;	//when it was last fired, lower is older
+		bool active;				//currently in the scene
+	};
+
+	unsigned int findSlot();
+	void retire(Projectile& a_projectile);
+
+	PhysicsDemoScene* m_app;
+
+	std::vector<Projectile> m_projectiles;
+	unsigned int m_capacity;
+	unsigned int m_activeCount;
+	unsigned int m_spawnCount;
+
+	float m_radius;
+	float m_density;
+};
+
+#endif // !_PROJECTILEPOOL_H_
@@ -0,0 +1,209 @@
+#include "RenderState.h"
+
+#include <cstring>
+
+RenderState::RenderState() : m_step(1) {}
+RenderState::~RenderState() {}
+
+void RenderState::addBodies(const std::vector<PxRigidActor*>& a_actors)
+{
+	for (unsigned int i = getBodyCount(); i < a_actors.size(); i++)
+	{
+		PxRigidActor* actor = a_actors[i];
+		PxTransform pose = actor->getGlobalPose();
+
+		m_positions.push_back(pose.p);
+		m_rotations.push_back(pose.q);
+		m_previousPositions.push_back(pose.p);
+		m_previousRotations.push_back(pose.q);
+		m_movedStep.push_back(0);
+		m_enabled.push_back(actor->getScene() != nullptr);
+		m_userData.push_back(actor->userData);
+		m_renderPoses.push_back(pose);
+		m_dirty.push_back(0);
+
+		//bounds from PhysX once, after that they follow the pose
+		PxBounds3 bounds = actor->getWorldBounds();
+		PxVec3 centre = bounds.isEmpty() ? PxVec3(0) : pose.transformInv(bounds.getCenter());
+		float radius = bounds.isEmpty() ? 0 : bounds.getExtents().magnitude();
+
+		m_boundsCentres.push_back(centre);
+		m_boundsRadii.push_back(radius);
+		m_sphereX.push_back(0);
+		m_sphereY.push_back(0);
+		m_sphereZ.push_back(0);
+		m_sphereRadius.push_back(radius);
+		updateBounds(i);
+
+		m_bodyLookup[actor] = i;
+		markDirty(i);
+
+		//colour
+		vec4 colour = vec4(1, 0, 0, 1);
+
+		if (actor->getName() != nullptr && strcmp(actor->getName(), "Pickup1"))	 //pickups are green
+			colour = vec4(0, 1, 0, 1);
+
+		//describe the shapes once, their geometry doesn't change
+		PxU32 nShapes = actor->getNbShapes();
+		m_shapeStart.push_back((unsigned int)m_shapes.size());
+		m_shapeCount.push_back(nShapes);
+
+		for (PxU32 s = 0; s < nShapes; s++)
+		{
+			PxShape* pShape;
+			actor->getShapes(&pShape, 1, s);
+
+			Shape shape;
+			shape.body = i;
+			shape.type = pShape->getGeometryType();
+			shape.localPose = pShape->getLocalPose();
+			shape.size = PxVec3(1);
+			shape.colour = colour;
+			shape.instance = 0xffffffff;
+
+			switch (shape.type)
+			{
+			case PxGeometryType::eBOX:
+				{
+					PxBoxGeometry geometry;
+					if (pShape->getBoxGeometry(geometry))
+						shape.size = geometry.halfExtents;
+				}
+				break;
+			case PxGeometryType::eSPHERE:
+				{
+					PxSphereGeometry geometry;
+					if (pShape->getSphereGeometry(geometry))
+						shape.size = PxVec3(geometry.radius, 0, 0);
+				}
+				break;
+			case PxGeometryType::eCAPSULE:
+				{
+					PxCapsuleGeometry geometry;
+					if (pShape->getCapsuleGeometry(geometry))
+						shape.size = PxVec3(geometry.radius, geometry.halfHeight, 0);
+				}
+				break;
+			default:
+				break;
+			}
+
+			m_shapes.push_back(shape);
+		}
+	}
+}
+
+void RenderState::update(PxScene* a_scene)
+{
+	m_step++;
+
+	//only the actors which moved are in the list
+	PxU32 nTransforms = 0;
+	const PxActiveTransform* transforms = a_scene->getActiveTransforms(nTransforms);
+
+	for (PxU32 i = 0; i < nTransforms; i++)
+	{
+		auto body = m_bodyLookup.find(transforms[i].actor);
+		if (body == m_bodyLookup.end())
+			continue;
+
+		unsigned int index = body->second;
+
+		m_previousPositions[index] = m_positions[index];
+		m_previousRotations[index] = m_rotations[index];
+
+		m_positions[index] = transforms[i].actor2World.p;
+		m_rotations[index] = transforms[i].actor2World.q;
+
+		m_movedStep[index] = m_step;
+		markDirty(index);
+	}
+}
+
+void RenderState::setPose(unsigned int a_body, const PxTransform& a_pose)
+{
+	if (a_body >= getBodyCount())
+		return;
+
+	m_positions[a_body] = a_pose.p;
+	m_rotations[a_body] = a_pose.q;
+	m_previousPositions[a_body] = a_pose.p;
+	m_previousRotations[a_body] = a_pose.q;
+
+	markDirty(a_body);
+}
+
+unsigned int RenderState::findBody(const PxActor* a_actor) const
+{
+	auto body = m_bodyLookup.find(a_actor);
+	if (body == m_bodyLookup.end())
+		return getBodyCount();
+
+	return body->second;
+}
+
+void RenderState::setEnabled(unsigned int a_body, bool a_enabled)
+{
+	if (a_body >= getBodyCount())
+		return;
+
+	m_enabled[a_body] = a_enabled;
+
+	markDirty(a_body);
+}
+
+void RenderState::markDirty(unsigned int a_body)
+{
+	if (m_dirty[a_body])
+		return;
+
+	m_dirty[a_body] = 1;
+	m_dirtyList.push_back(a_body);
+}
+
+void RenderState::updateBounds(unsigned int a_body)
+{
+	PxVec3 centre = m_renderPoses[a_body].transform(m_boundsCentres[a_body]);
+
+	m_sphereX[a_body] = centre.x;
+	m_sphereY[a_body] = centre.y;
+	m_sphereZ[a_body] = centre.z;
+}
+
+void RenderState::clearSettled()
+{
+	//anything which moved in the latest step is still blending, keep it for next frame
+	unsigned int kept = 0;
+	for (auto body : m_dirtyList)
+	{
+		if (m_movedStep[body] == m_step)
+			m_dirtyList[kept++] = body;
+		else
+			m_dirty[body] = 0;
+	}
+
+	m_dirtyList.resize(kept);
+}
+
+PxTransform RenderState::getRenderPose(unsigned int a_body, float a_alpha) const
+{
+	//didn't move in the last step, nothing to blend
+	if (m_movedStep[a_body] != m_step)
+		return PxTransform(m_positions[a_body], m_rotations[a_body]);
+
+	const PxVec3& previousPosition = m_previousPositions[a_body];
+	const PxQuat& previousRotation = m_previousRotations[a_body];
+
+	//position
+	PxVec3 position = previousPosition + (m_positions[a_body] - previousPosition) * a_alpha;
+
+	//rotation (normalised lerp, flipped to take the short way round)
+	PxQuat target = m_rotations[a_body];
+	if (previousRotation.dot(target) < 0)
+		target = -target;
+
+	PxQuat rotation = (previousRotation * (1.0f - a_alpha) + target * a_alpha).getNormalized();
+
+	return PxTransform(position, rotation);
+}
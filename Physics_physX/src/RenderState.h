@@ -0,0 +1,102 @@
+#ifndef _RENDERSTATE_H_
+#define _RENDERSTATE_H_
+
+#include <PxPhysicsAPI.h>
+
+#include <unordered_map>
+#include <vector>
+
+#include "glm_includes.h"
+
+using namespace physx;
+
+//contiguous copy of everything rendering and gameplay need from PhysX, so nobody has to ask
+//PhysX per actor. Bodies are kept in the same order as PhysicsDemoScene::g_PhysXActors.
+class RenderState
+{
+public:
+	//one collision shape, shapes of the same body are next to each other
+	struct Shape
+	{
+		unsigned int body;
+		PxGeometryType::Enum type;
+		PxTransform localPose;
+		PxVec3 size;	//box half extents, or radius and half height in x and y
+		vec4 colour;
+		unsigned int instance;	//PrimitiveRenderer handle, set by whoever draws it
+	};
+
+	RenderState();
+	~RenderState();
+
+	//pick up any actors added to the list since the last call
+	void addBodies(const std::vector<PxRigidActor*>& a_actors);
+
+	//copy the poses of everything that moved in the last step, call straight after fetchResults
+	void update(PxScene* a_scene);
+
+	//move a body without blending from where it was, eg. when a pooled actor is reused
+	void setPose(unsigned int a_body, const PxTransform& a_pose);
+
+	//bodies which aren't in the scene are skipped when drawing
+	void setEnabled(unsigned int a_body, bool a_enabled);
+
+	//pose of a body a_alpha of the way between the last two steps
+	PxTransform getRenderPose(unsigned int a_body, float a_alpha) const;
+
+	//bodies whose render pose needs working out again: moved in the last step, or were
+	//added, moved by setPose or enabled/disabled since they were last drawn. resting bodies
+	//drop out, so a settled scene has none
+	const std::vector<unsigned int>& getDirtyBodies() const { return m_dirtyList; }
+
+	bool isDirty(unsigned int a_body) const { return m_dirty[a_body] != 0; }
+
+	//call once the dirty bodies have been drawn, forgets the ones which have stopped moving
+	void clearSettled();
+
+	//moves a body's bounding sphere to its render pose
+	void updateBounds(unsigned int a_body);
+
+	unsigned int getBodyCount() const { return (unsigned int)m_positions.size(); }
+
+	//index of an actor's body, getBodyCount() if it isn't tracked
+	unsigned int findBody(const PxActor* a_actor) const;
+
+public:
+	//per body
+	std::vector<PxVec3> m_positions;
+	std::vector<PxQuat> m_rotations;
+	std::vector<PxVec3> m_previousPositions;
+	std::vector<PxQuat> m_previousRotations;
+	std::vector<unsigned int> m_movedStep;	//last step the body moved in
+	std::vector<unsigned char> m_enabled;
+	std::vector<void*> m_userData;
+	std::vector<PxTransform> m_renderPoses;	//filled in by the scene for dirty bodies
+	std::vector<unsigned int> m_shapeStart;	//first of the body's shapes in m_shapes
+	std::vector<unsigned int> m_shapeCount;
+
+	//bounding sphere around all of a body's shapes, centre relative to the body
+	std::vector<PxVec3> m_boundsCentres;
+	std::vector<float> m_boundsRadii;
+
+	//the same spheres in world space at the render pose, one array per component for Frustum::testSpheres
+	std::vector<float> m_sphereX;
+	std::vector<float> m_sphereY;
+	std::vector<float> m_sphereZ;
+	std::vector<float> m_sphereRadius;
+
+	//shape table
+	std::vector<Shape> m_shapes;
+
+private:
+	void markDirty(unsigned int a_body);
+
+	std::unordered_map<const PxActor*, unsigned int> m_bodyLookup;
+
+	std::vector<unsigned char> m_dirty;
+	std::vector<unsigned int> m_dirtyList;
+
+	unsigned int m_step;
+};
+
+#endif // !_RENDERSTATE_H_
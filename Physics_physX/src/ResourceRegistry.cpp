@@ -0,0 +1,224 @@
+#include "ResourceRegistry.h"
+
+#include "ShaderLoading.h"
+#include "Profiler.h"
+
+#include <cstdio>
+
+//models
+
+void ModelResource::upload(const MeshCache& a_cache)
+{
+	PROFILE_ZONE("ModelResource::upload");
+
+	beginUpload(a_cache);
+	createProgram();
+
+	//textures first, the meshes look theirs up
+	for (unsigned int i = 0; i < a_cache.getHeader().textureCount; i++)
+		uploadTexture(a_cache, i);
+
+	for (unsigned int i = 0; i < a_cache.getHeader().meshCount; i++)
+		uploadMesh(a_cache, i);
+
+	m_ready = true;
+}
+
+void ModelResource::beginUpload(const MeshCache& a_cache)
+{
+	const MeshCache::Header& header = a_cache.getHeader();
+
+	//create vectors big enough for all meshes and textures
+	m_meshes = std::vector<ShaderObjs::OpenGLData>(header.meshCount);
+	m_meshTextures = std::vector<unsigned int>(header.meshCount, 0);
+	m_textures = std::vector<unsigned int>(header.textureCount, 0);
+
+	//bounds for culling
+	m_meshMin = std::vector<vec3>(header.meshCount);
+	m_meshMax = std::vector<vec3>(header.meshCount);
+	for (unsigned int i = 0; i < header.meshCount; i++)
+	{
+		const MeshCache::Mesh& mesh = a_cache.getMesh(i);
+		m_meshMin[i] = vec3(mesh.boundsMin[0], mesh.boundsMin[1], mesh.boundsMin[2]);
+		m_meshMax[i] = vec3(mesh.boundsMax[0], mesh.boundsMax[1], mesh.boundsMax[2]);
+	}
+
+	m_boundsMin = vec3(header.boundsMin[0], header.boundsMin[1], header.boundsMin[2]);
+	m_boundsMax = vec3(header.boundsMax[0], header.boundsMax[1], header.boundsMax[2]);
+	m_boundsKnown = true;
+}
+
+bool ModelResource::createProgram()
+{
+	if (m_program == 0)
+		m_program = m_registry->acquireProgram("./data/shaders/textured_vertex.glsl", "./data/shaders/textured_fragment.glsl");
+
+	return m_program != 0;
+}
+
+size_t ModelResource::uploadTexture(const MeshCache& a_cache, unsigned int a_index)
+{
+	//the pixels are already decoded in the bake
+	const MeshCache::Texture& texture = a_cache.getTexture(a_index);
+	const GLenum formats[] = { GL_RED, GL_RG, GL_RGB, GL_RGBA };
+	GLenum format = formats[texture.channels - 1];
+
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+	glGenTextures(1, &m_textures[a_index]);
+	glBindTexture(GL_TEXTURE_2D, m_textures[a_index]);
+	glTexImage2D(GL_TEXTURE_2D, 0, format, texture.width, texture.height, 0, format, GL_UNSIGNED_BYTE, a_cache.getData(texture.offset));
+	glGenerateMipmap(GL_TEXTURE_2D);
+
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	return (size_t)texture.bytes;
+}
+
+size_t ModelResource::uploadMesh(const MeshCache& a_cache, unsigned int a_index)
+{
+	const MeshCache::Mesh& mesh = a_cache.getMesh(a_index);
+	CompactMesh::Format format = MeshCache::getFormat(mesh);
+
+	//straight from the mapping to GL
+	CompactMesh::upload(m_meshes[a_index], format, a_cache.getData(mesh.vertexOffset), (size_t)mesh.vertexBytes,
+						a_cache.getData(mesh.indexOffset), mesh.indexCount);
+
+	if (mesh.diffuseTexture >= 0)
+		m_meshTextures[a_index] = m_textures[mesh.diffuseTexture];
+
+	return (size_t)mesh.vertexBytes + mesh.indexCount * (format.shortIndices ? sizeof(unsigned short) : sizeof(unsigned int));
+}
+
+void ModelResource::release()
+{
+	m_registry->releaseModel(this);
+}
+
+//registry
+
+ResourceRegistry::~ResourceRegistry()
+{
+	destroy();
+}
+
+ModelResource* ResourceRegistry::acquireModel(const char* a_filename, const CompactMesh::Layout& a_layout, bool& a_load)
+{
+	//the same file packed another way is a different set of buffers
+	std::string key = std::string(a_filename) + "|" + std::to_string((int)a_layout.texCoord) + (a_layout.normals ? "n" : "");
+
+	ModelResource*& model = m_models[key];
+	if (model == nullptr)
+	{
+		model = new ModelResource();
+		model->m_registry = this;
+		model->m_key = key;
+	}
+
+	model->m_refs++;
+
+	//new, or an earlier load failed and it's worth another go
+	a_load = model->m_ready == false && model->m_loading == false;
+	if (a_load)
+		model->m_loading = true;
+
+	return model;
+}
+
+void ResourceRegistry::retainModel(ModelResource* a_model)
+{
+	a_model->m_refs++;
+}
+
+void ResourceRegistry::releaseModel(ModelResource* a_model)
+{
+	if (a_model == nullptr || --a_model->m_refs > 0)
+		return;
+
+	m_models.erase(a_model->m_key);
+	freeModel(a_model);
+}
+
+void ResourceRegistry::freeModel(ModelResource* a_model)
+{
+	//only what was uploaded, a model which never streamed in has nothing in GL
+	for (auto& mesh : a_model->m_meshes)
+	{
+		if (mesh.VAO == 0)
+			continue;
+
+		glDeleteBuffers(1, &mesh.VBO);
+		glDeleteBuffers(1, &mesh.IBO);
+		glDeleteVertexArrays(1, &mesh.VAO);
+	}
+
+	for (auto texture : a_model->m_textures)
+	{
+		if (texture != 0)
+			glDeleteTextures(1, &texture);
+	}
+
+	if (a_model->m_program != 0)
+		a_model->m_registry->releaseProgram(a_model->m_program);
+
+	delete a_model;
+}
+
+unsigned int ResourceRegistry::acquireProgram(const char* a_vertexFile, const char* a_fragmentFile)
+{
+	std::string key = std::string(a_vertexFile) + "|" + a_fragmentFile;
+
+	auto found = m_programs.find(key);
+	if (found != m_programs.end())
+	{
+		found->second.refs++;
+		return found->second.id;
+	}
+
+	unsigned int id = 0;
+	if (CreateShaderProgram(a_vertexFile, nullptr, a_fragmentFile, &id) == false)
+		return 0;
+
+	Program program = { id, 1 };
+	m_programs[key] = program;
+
+	return id;
+}
+
+void ResourceRegistry::releaseProgram(unsigned int a_program)
+{
+	for (auto it = m_programs.begin(); it != m_programs.end(); ++it)
+	{
+		if (it->second.id != a_program)
+			continue;
+
+		if (--it->second.refs == 0)
+		{
+			glDeleteProgram(a_program);
+			m_programs.erase(it);
+		}
+		return;
+	}
+}
+
+void ResourceRegistry::destroy()
+{
+	if (m_models.empty() == false)
+		printf("Warning: %u models still referenced when the resource registry was destroyed\n", (unsigned int)m_models.size());
+
+	//the models let go of their programs as they go
+	auto models = m_models;
+	m_models.clear();
+	for (auto& model : models)
+		freeModel(model.second);
+
+	for (auto& program : m_programs)
+		glDeleteProgram(program.second.id);
+	m_programs.clear();
+}
@@ -0,0 +1,98 @@
+#ifndef _RESOURCEREGISTRY_H_
+#define _RESOURCEREGISTRY_H_
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "glm_includes.h"
+#include "shader_data_objects.h"
+
+#include "CompactMesh.h"
+#include "MeshCache.h"
+
+class ResourceRegistry;
+
+//the GL side of one baked model: its buffers, textures and program. every FBXActor drawing the
+//same file with the same vertex layout holds a reference to one of these instead of its own copy
+class ModelResource
+{
+public:
+	//uploads a baked model's buffers and textures all at once
+	void upload(const MeshCache& a_cache);
+
+	//the same in pieces, beginUpload first then the program and every texture before any mesh.
+	//each piece returns the bytes it uploaded
+	void beginUpload(const MeshCache& a_cache);
+	bool createProgram();
+	size_t uploadTexture(const MeshCache& a_cache, unsigned int a_index);
+	size_t uploadMesh(const MeshCache& a_cache, unsigned int a_index);
+
+	//gives back a reference from the registry it came from
+	void release();
+
+public:
+	//model meshes
+	std::vector<ShaderObjs::OpenGLData> m_meshes;
+	std::vector<unsigned int> m_meshTextures;	//diffuse texture of each mesh, 0 for none
+	std::vector<unsigned int> m_textures;
+
+	//model space bounds of each mesh, then of all of them, for culling
+	std::vector<vec3> m_meshMin;
+	std::vector<vec3> m_meshMax;
+	vec3 m_boundsMin;
+	vec3 m_boundsMax;
+
+	//shader program, shared through the registry too
+	unsigned int m_program = 0;
+
+	bool m_ready = false;			//everything is uploaded, drawn for real from here on
+	bool m_boundsKnown = false;		//the bounds are filled in, before m_ready when streaming
+	bool m_loading = false;			//someone has taken on loading it
+
+private:
+	friend class ResourceRegistry;
+
+	ResourceRegistry* m_registry = nullptr;
+	std::string m_key;
+	unsigned int m_refs = 0;
+};
+
+//hands out shared models and shader programs, keyed by their files, and frees each once the last
+//reference to it is released. memory and load time then follow the number of unique assets
+//rather than the number of actors using them.
+class ResourceRegistry
+{
+public:
+	~ResourceRegistry();
+
+	//a new reference to a_filename's model baked with a_layout. a_load is set when nothing has
+	//loaded it yet, the caller is then expected to load it and clear m_loading if that fails
+	ModelResource* acquireModel(const char* a_filename, const CompactMesh::Layout& a_layout, bool& a_load);
+	void retainModel(ModelResource* a_model);
+	void releaseModel(ModelResource* a_model);
+
+	//compiles the program on its first acquire, 0 if it failed
+	unsigned int acquireProgram(const char* a_vertexFile, const char* a_fragmentFile);
+	void releaseProgram(unsigned int a_program);
+
+	//frees whatever is still referenced, call before the GL context goes
+	void destroy();
+
+	unsigned int getModelCount() const { return (unsigned int)m_models.size(); }
+	unsigned int getProgramCount() const { return (unsigned int)m_programs.size(); }
+
+private:
+	struct Program
+	{
+		unsigned int id;
+		unsigned int refs;
+	};
+
+	static void freeModel(ModelResource* a_model);
+
+	std::unordered_map<std::string, ModelResource*> m_models;
+	std::unordered_map<std::string, Program> m_programs;
+};
+
+#endif // !_RESOURCEREGISTRY_H_
@@ -0,0 +1,115 @@
+#include "SceneQueries.h"
+
+#include <cstdio>
+
+//skips shapes in any of the groups in the query's word0
+static PxQueryHitType::Enum ignoreGroupsFilter(PxFilterData a_queryFilterData, PxFilterData a_objectFilterData,
+											   const void* a_constantBlock, PxU32 a_constantBlockSize, PxHitFlags& a_hitFlags)
+{
+	if ((a_queryFilterData.word0 & a_objectFilterData.word0) != 0)
+		return PxQueryHitType::eNONE;
+
+	return PxQueryHitType::eBLOCK;
+}
+
+SceneQueries::SceneQueries()
+	: m_batch(nullptr),
+	m_raycastCount(0),
+	m_sweepCount(0),
+	m_overlapCount(0),
+	m_lastExecuteCount(0),
+	m_warnedFull(false)
+{}
+
+SceneQueries::~SceneQueries() {}
+
+void SceneQueries::create(PxScene* a_scene, unsigned int a_maxRaycasts, unsigned int a_maxSweeps, unsigned int a_maxOverlaps,
+						  unsigned int a_maxTouches)
+{
+	m_raycastResults.resize(a_maxRaycasts);
+	m_sweepResults.resize(a_maxSweeps);
+	m_overlapResults.resize(a_maxOverlaps);
+	m_overlapTouches.resize(a_maxTouches);
+
+	PxBatchQueryDesc desc(a_maxRaycasts, a_maxSweeps, a_maxOverlaps);
+	desc.preFilterShader = ignoreGroupsFilter;
+
+	//raycasts and sweeps only report the closest hit so they don't need touch buffers
+	desc.queryMemory.userRaycastResultBuffer = m_raycastResults.empty() ? nullptr : &m_raycastResults[0];
+	desc.queryMemory.userSweepResultBuffer = m_sweepResults.empty() ? nullptr : &m_sweepResults[0];
+	desc.queryMemory.userOverlapResultBuffer = m_overlapResults.empty() ? nullptr : &m_overlapResults[0];
+	desc.queryMemory.userOverlapTouchBuffer = m_overlapTouches.empty() ? nullptr : &m_overlapTouches[0];
+	desc.queryMemory.overlapTouchBufferSize = a_maxTouches;
+
+	m_batch = a_scene->createBatchQuery(desc);
+}
+
+void SceneQueries::destroy()
+{
+	if (m_batch != nullptr)
+		m_batch->release();
+	m_batch = nullptr;
+}
+
+unsigned int SceneQueries::raycast(const PxVec3& a_origin, const PxVec3& a_direction, float a_distance, PxU32 a_ignore)
+{
+	if (m_raycastCount == m_raycastResults.size())
+	{
+		if (m_warnedFull == false)
+			printf("Warning: scene query batch is full, dropping raycasts\n");
+		m_warnedFull = true;
+		return INVALID;
+	}
+
+	PxQueryFilterData filter(PxFilterData(a_ignore, 0, 0, 0), PxQueryFlag::eSTATIC | PxQueryFlag::eDYNAMIC | PxQueryFlag::ePREFILTER);
+	m_batch->raycast(a_origin, a_direction, a_distance, 0, PxHitFlag::ePOSITION | PxHitFlag::eNORMAL | PxHitFlag::eDISTANCE, filter);
+
+	return m_raycastCount++;
+}
+
+unsigned int SceneQueries::sweep(const PxGeometry& a_geometry, const PxTransform& a_pose, const PxVec3& a_direction, float a_distance,
+								 PxU32 a_ignore)
+{
+	if (m_sweepCount == m_sweepResults.size())
+	{
+		if (m_warnedFull == false)
+			printf("Warning: scene query batch is full, dropping sweeps\n");
+		m_warnedFull = true;
+		return INVALID;
+	}
+
+	PxQueryFilterData filter(PxFilterData(a_ignore, 0, 0, 0), PxQueryFlag::eSTATIC | PxQueryFlag::eDYNAMIC | PxQueryFlag::ePREFILTER);
+	m_batch->sweep(a_geometry, a_pose, a_direction, a_distance, 0, PxHitFlag::ePOSITION | PxHitFlag::eNORMAL | PxHitFlag::eDISTANCE, filter);
+
+	return m_sweepCount++;
+}
+
+unsigned int SceneQueries::overlap(const PxGeometry& a_geometry, const PxTransform& a_pose, PxU16 a_maxTouches, PxU32 a_ignore)
+{
+	if (m_overlapCount == m_overlapResults.size())
+	{
+		if (m_warnedFull == false)
+			printf("Warning: scene query batch is full, dropping overlaps\n");
+		m_warnedFull = true;
+		return INVALID;
+	}
+
+	//overlaps can't block, everything they find is a touch
+	PxQueryFilterData filter(PxFilterData(a_ignore, 0, 0, 0),
+		PxQueryFlag::eSTATIC | PxQueryFlag::eDYNAMIC | PxQueryFlag::ePREFILTER | PxQueryFlag::eNO_BLOCK);
+	m_batch->overlap(a_geometry, a_pose, a_maxTouches, filter);
+
+	return m_overlapCount++;
+}
+
+void SceneQueries::execute()
+{
+	m_lastExecuteCount = m_raycastCount + m_sweepCount + m_overlapCount;
+
+	if (m_batch != nullptr && m_lastExecuteCount > 0)
+		m_batch->execute();
+
+	m_raycastCount = 0;
+	m_sweepCount = 0;
+	m_overlapCount = 0;
+}
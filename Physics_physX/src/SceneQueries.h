@@ -0,0 +1,66 @@
+#ifndef _SCENEQUERIES_H_
+#define _SCENEQUERIES_H_
+
+#include <PxPhysicsAPI.h>
+
+#include <vector>
+
+using namespace physx;
+
+//batches raycasts, sweeps and overlaps through a single PxBatchQuery. queries are queued
+//during the frame, run together by execute() and their results read back by the handle the
+//queue call returned. all result and hit buffers are allocated once in create().
+class SceneQueries
+{
+public:
+	//query groups, set on a shape's query filter data (word0) so queries can skip them
+	enum Group
+	{
+		GROUP_PLAYER = 1 << 0,
+		GROUP_PROJECTILE = 1 << 1,
+	};
+
+	//returned when the batch is full
+	static const unsigned int INVALID = 0xffffffff;
+
+	SceneQueries();
+	~SceneQueries();
+
+	void create(PxScene* a_scene, unsigned int a_maxRaycasts, unsigned int a_maxSweeps, unsigned int a_maxOverlaps,
+				unsigned int a_maxTouches = 256);
+	void destroy();
+
+	//queue a query for the next execute(), a_ignore is a mask of Groups to skip
+	unsigned int raycast(const PxVec3& a_origin, const PxVec3& a_direction, float a_distance, PxU32 a_ignore = 0);
+	unsigned int sweep(const PxGeometry& a_geometry, const PxTransform& a_pose, const PxVec3& a_direction, float a_distance,
+					   PxU32 a_ignore = 0);
+	unsigned int overlap(const PxGeometry& a_geometry, const PxTransform& a_pose, PxU16 a_maxTouches, PxU32 a_ignore = 0);
+
+	//runs everything queued since the last execute, results stay valid until the next one
+	void execute();
+
+	//a_handle is from the queue call before the last execute
+	const PxRaycastQueryResult&	getRaycast(unsigned int a_handle) const { return m_raycastResults[a_handle]; }
+	const PxSweepQueryResult&	getSweep(unsigned int a_handle) const { return m_sweepResults[a_handle]; }
+	const PxOverlapQueryResult&	getOverlap(unsigned int a_handle) const { return m_overlapResults[a_handle]; }
+
+	unsigned int getQueriesLastExecute() const { return m_lastExecuteCount; }
+
+private:
+	PxBatchQuery* m_batch;
+
+	std::vector<PxRaycastQueryResult> m_raycastResults;
+	std::vector<PxSweepQueryResult> m_sweepResults;
+	std::vector<PxOverlapQueryResult> m_overlapResults;
+	std::vector<PxOverlapHit> m_overlapTouches;
+
+	//queued since the last execute
+	unsigned int m_raycastCount;
+	unsigned int m_sweepCount;
+	unsigned int m_overlapCount;
+
+	unsigned int m_lastExecuteCount;
+	bool m_warnedFull;
+};
+
+#endif // !_SCENEQUERIES_H_
@@ -0,0 +1,199 @@
+#include "SimulationEvents.h"
+
+#include <cstdio>
+
+SimulationEvents::SimulationEvents() : m_dropped(0), m_warnedDropped(false) {}
+SimulationEvents::~SimulationEvents() {}
+
+void SimulationEvents::create(unsigned int a_capacity)
+{
+	m_contacts.create(a_capacity);
+	m_triggers.create(a_capacity);
+	m_activity.create(a_capacity);
+	m_controllerHits.create(a_capacity);
+	m_outOfBounds.create(a_capacity);
+}
+
+PxFilterFlags SimulationEvents::filterShader(PxFilterObjectAttributes a_attributes0, PxFilterData a_filterData0,
+											 PxFilterObjectAttributes a_attributes1, PxFilterData a_filterData1,
+											 PxPairFlags& a_pairFlags, const void* a_constantBlock, PxU32 a_constantBlockSize)
+{
+	if (PxFilterObjectIsTrigger(a_attributes0) || PxFilterObjectIsTrigger(a_attributes1))
+	{
+		a_pairFlags = PxPairFlag::eTRIGGER_DEFAULT;
+		return PxFilterFlag::eDEFAULT;
+	}
+
+	a_pairFlags = PxPairFlag::eCONTACT_DEFAULT;
+
+	//only pairs which asked for it, so a settled pile doesn't fill the queue every step
+	if (((a_filterData0.word0 | a_filterData1.word0) & REPORT_CONTACTS) != 0)
+		a_pairFlags |= PxPairFlag::eNOTIFY_TOUCH_FOUND | PxPairFlag::eNOTIFY_CONTACT_POINTS;
+
+	return PxFilterFlag::eDEFAULT;
+}
+
+void SimulationEvents::pushControllerHit(const PxControllerShapeHit& a_hit)
+{
+	ControllerHitEvent event;
+	event.actor = a_hit.actor;
+	event.point = PxVec3((float)a_hit.worldPos.x, (float)a_hit.worldPos.y, (float)a_hit.worldPos.z);
+	event.direction = a_hit.dir;
+	event.length = a_hit.length;
+
+	if (m_controllerHits.push(event) == false)
+		m_dropped++;
+}
+
+void SimulationEvents::onWake(PxActor** a_actors, PxU32 a_count)
+{
+	for (PxU32 i = 0; i < a_count; i++)
+	{
+		ActivityEvent event = { a_actors[i], true };
+		if (m_activity.push(event) == false)
+			m_dropped++;
+	}
+}
+
+void SimulationEvents::onSleep(PxActor** a_actors, PxU32 a_count)
+{
+	for (PxU32 i = 0; i < a_count; i++)
+	{
+		ActivityEvent event = { a_actors[i], false };
+		if (m_activity.push(event) == false)
+			m_dropped++;
+	}
+}
+
+void SimulationEvents::onContact(const PxContactPairHeader& a_pairHeader, const PxContactPair* a_pairs, PxU32 a_nbPairs)
+{
+	//the actors may be gone by the time we dispatch
+	if (a_pairHeader.flags & (PxContactPairHeaderFlag::eREMOVED_ACTOR_0 | PxContactPairHeaderFlag::eREMOVED_ACTOR_1))
+		return;
+
+	const PxU32 maxPoints = 8;
+	PxContactPairPoint points[maxPoints];
+
+	for (PxU32 i = 0; i < a_nbPairs; i++)
+	{
+		const PxContactPair& pair = a_pairs[i];
+		if ((pair.events & PxPairFlag::eNOTIFY_TOUCH_FOUND) == false)
+			continue;
+
+		PxU32 count = pair.extractContacts(points, maxPoints);
+		if (count == 0)
+			continue;
+
+		ContactEvent event;
+		event.actors[0] = a_pairHeader.actors[0];
+		event.actors[1] = a_pairHeader.actors[1];
+		event.point = points[0].position;
+		event.normal = points[0].normal;
+		event.impulse = 0;
+		for (PxU32 p = 0; p < count; p++)
+			event.impulse += points[p].impulse.magnitude();
+
+		if (m_contacts.push(event) == false)
+			m_dropped++;
+	}
+}
+
+void SimulationEvents::onTrigger(PxTriggerPair* a_pairs, PxU32 a_count)
+{
+	for (PxU32 i = 0; i < a_count; i++)
+	{
+		const PxTriggerPair& pair = a_pairs[i];
+		if (pair.flags & (PxTriggerPairFlag::eREMOVED_SHAPE_TRIGGER | PxTriggerPairFlag::eREMOVED_SHAPE_OTHER))
+			continue;
+
+		TriggerEvent event;
+		event.trigger = pair.triggerActor;
+		event.other = pair.otherActor;
+		event.entered = pair.status == PxPairFlag::eNOTIFY_TOUCH_FOUND;
+
+		if (m_triggers.push(event) == false)
+			m_dropped++;
+	}
+}
+
+void SimulationEvents::onObjectOutOfBounds(PxShape& a_shape, PxActor& a_actor)
+{
+	//sent once per shape, the handler has to cope with seeing an actor twice
+	PxRigidActor* actor = a_actor.is<PxRigidActor>();
+	if (actor == nullptr)
+		return;
+
+	OutOfBoundsEvent event = { actor };
+	if (m_outOfBounds.push(event) == false)
+		m_dropped++;
+}
+
+void SimulationEvents::onObjectOutOfBounds(PxAggregate& a_aggregate)
+{
+	//the aggregate may be gone by the time we dispatch, so queue its actors instead
+	const PxU32 batchSize = 16;
+	PxActor* actors[batchSize];
+
+	for (PxU32 start = 0; start < a_aggregate.getNbActors(); start += batchSize)
+	{
+		PxU32 count = a_aggregate.getActors(actors, batchSize, start);
+		for (PxU32 i = 0; i < count; i++)
+		{
+			PxRigidActor* actor = actors[i]->is<PxRigidActor>();
+			if (actor == nullptr)
+				continue;
+
+			OutOfBoundsEvent event = { actor };
+			if (m_outOfBounds.push(event) == false)
+				m_dropped++;
+		}
+	}
+}
+
+unsigned int SimulationEvents::dispatch(SimulationEventHandler& a_handler)
+{
+	unsigned int handled = 0;
+
+	ContactEvent contact;
+	while (m_contacts.pop(contact))
+	{
+		a_handler.onContact(contact);
+		handled++;
+	}
+
+	TriggerEvent trigger;
+	while (m_triggers.pop(trigger))
+	{
+		a_handler.onTrigger(trigger);
+		handled++;
+	}
+
+	ActivityEvent activity;
+	while (m_activity.pop(activity))
+	{
+		a_handler.onActivity(activity);
+		handled++;
+	}
+
+	ControllerHitEvent hit;
+	while (m_controllerHits.pop(hit))
+	{
+		a_handler.onControllerHit(hit);
+		handled++;
+	}
+
+	OutOfBoundsEvent outOfBounds;
+	while (m_outOfBounds.pop(outOfBounds))
+	{
+		a_handler.onOutOfBounds(outOfBounds);
+		handled++;
+	}
+
+	if (m_dropped > 0 && m_warnedDropped == false)
+	{
+		printf("Warning: simulation event queues are full, %u events dropped\n", m_dropped.load());
+		m_warnedDropped = true;
+	}
+
+	return handled;
+}
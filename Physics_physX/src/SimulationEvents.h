@@ -0,0 +1,113 @@
+#ifndef _SIMULATIONEVENTS_H_
+#define _SIMULATIONEVENTS_H_
+
+#include <PxPhysicsAPI.h>
+
+#include "SpscQueue.h"
+
+using namespace physx;
+
+struct ContactEvent
+{
+	PxRigidActor*	actors[2];
+	PxVec3			point;		// first contact point
+	PxVec3			normal;		// points from actors[1] to actors[0]
+	float			impulse;	// summed over all the pair's contact points
+};
+
+struct TriggerEvent
+{
+	PxRigidActor*	trigger;
+	PxRigidActor*	other;
+	bool			entered;	// false when other left the trigger
+};
+
+struct ActivityEvent
+{
+	PxActor*		actor;
+	bool			awake;		// false when the actor fell asleep
+};
+
+struct OutOfBoundsEvent
+{
+	PxRigidActor*	actor;		// left every broadphase region, one event per actor of an aggregate
+};
+
+struct ControllerHitEvent
+{
+	PxRigidActor*	actor;		// what the character controller walked into
+	PxVec3			point;
+	PxVec3			direction;	// the controller's motion
+	float			length;		// how far it was trying to move
+};
+
+//gameplay code overrides the events it wants, they are all called on the main thread
+class SimulationEventHandler
+{
+public:
+	virtual ~SimulationEventHandler() {}
+
+	virtual void onContact(const ContactEvent& a_event) {}
+	virtual void onTrigger(const TriggerEvent& a_event) {}
+	virtual void onActivity(const ActivityEvent& a_event) {}
+	virtual void onControllerHit(const ControllerHitEvent& a_event) {}
+	virtual void onOutOfBounds(const OutOfBoundsEvent& a_event) {}
+};
+
+//receives PhysX's simulation events, copies them into preallocated queues while the scene is
+//being fetched and hands them to a handler afterwards, so reacting to them never happens
+//inside PhysX or allocates per event.
+//contacts are only reported for shapes with REPORT_CONTACTS in their simulation filter word0,
+//sleep and wake only for actors with PxActorFlag::eSEND_SLEEP_NOTIFIES.
+//also set as PxSceneDesc::broadPhaseCallback, which only reports anything with eMBP.
+class SimulationEvents : public PxSimulationEventCallback, public PxBroadPhaseCallback
+{
+public:
+	//simulation filter data word0 bits understood by filterShader
+	enum FilterBits
+	{
+		REPORT_CONTACTS = 1 << 0,
+	};
+
+	SimulationEvents();
+	~SimulationEvents();
+
+	void create(unsigned int a_capacity);
+
+	//set as PxSceneDesc::filterShader alongside this as the simulationEventCallback
+	static PxFilterFlags filterShader(PxFilterObjectAttributes a_attributes0, PxFilterData a_filterData0,
+									  PxFilterObjectAttributes a_attributes1, PxFilterData a_filterData1,
+									  PxPairFlags& a_pairFlags, const void* a_constantBlock, PxU32 a_constantBlockSize);
+
+	//character controllers report their hits through here
+	void pushControllerHit(const PxControllerShapeHit& a_hit);
+
+	//call after fetchResults on the main thread, returns how many events were handled
+	unsigned int dispatch(SimulationEventHandler& a_handler);
+
+	//events which didn't fit in their queue
+	unsigned int getDropped() const { return m_dropped; }
+
+	//PxSimulationEventCallback
+	virtual void onConstraintBreak(PxConstraintInfo* a_constraints, PxU32 a_count) {}
+	virtual void onWake(PxActor** a_actors, PxU32 a_count);
+	virtual void onSleep(PxActor** a_actors, PxU32 a_count);
+	virtual void onContact(const PxContactPairHeader& a_pairHeader, const PxContactPair* a_pairs, PxU32 a_nbPairs);
+	virtual void onTrigger(PxTriggerPair* a_pairs, PxU32 a_count);
+
+	//PxBroadPhaseCallback
+	virtual void onObjectOutOfBounds(PxShape& a_shape, PxActor& a_actor);
+	virtual void onObjectOutOfBounds(PxAggregate& a_aggregate);
+
+private:
+	SpscQueue<ContactEvent> m_contacts;
+	SpscQueue<TriggerEvent> m_triggers;
+	SpscQueue<ActivityEvent> m_activity;
+	SpscQueue<ControllerHitEvent> m_controllerHits;
+	SpscQueue<OutOfBoundsEvent> m_outOfBounds;
+
+	std::atomic<unsigned int> m_dropped;
+	bool m_warnedDropped;
+};
+
+#endif // !_SIMULATIONEVENTS_H_
@@ -0,0 +1,151 @@
+#include "SimulationStats.h"
+
+#include "Gizmos.h"
+
+namespace
+{
+	struct Series
+	{
+		const char* name;
+		float(*value)(const SimulationStats::Sample&);
+		vec4 colour;
+	};
+
+	//top to bottom in the overlay, same order as the CSV columns
+	const Series s_series[] =
+	{
+		{ "active bodies", [](const SimulationStats::Sample& s) { return (float)s.activeBodies; }, vec4(1, 0.5f, 0, 1) },
+		{ "contact pairs", [](const SimulationStats::Sample& s) { return (float)s.contactPairs; }, vec4(1, 0.9f, 0, 1) },
+		{ "broadphase volumes", [](const SimulationStats::Sample& s) { return (float)s.broadphaseVolumes; }, vec4(0.8f, 1, 0.4f, 1) },
+		{ "active constraints", [](const SimulationStats::Sample& s) { return (float)s.activeConstraints; }, vec4(0.6f, 1, 0, 1) },
+		{ "broadphase adds", [](const SimulationStats::Sample& s) { return (float)s.broadphaseAdds; }, vec4(0, 1, 0.6f, 1) },
+		{ "actors", [](const SimulationStats::Sample& s) { return (float)s.actors; }, vec4(0, 0.8f, 1, 1) },
+		{ "gizmo lines", [](const SimulationStats::Sample& s) { return (float)s.gizmoLines; }, vec4(0.4f, 0.5f, 1, 1) },
+		{ "gizmo tris", [](const SimulationStats::Sample& s) { return (float)s.gizmoTris; }, vec4(0.7f, 0.4f, 1, 1) },
+		{ "draw calls", [](const SimulationStats::Sample& s) { return (float)s.drawCalls; }, vec4(1, 0.4f, 0.7f, 1) },
+		{ "fetch wait ms", [](const SimulationStats::Sample& s) { return s.fetchWaitMs; }, vec4(1, 0.2f, 0.2f, 1) },
+	};
+
+	const unsigned int s_seriesCount = sizeof(s_series) / sizeof(s_series[0]);
+}
+
+SimulationStats::SimulationStats() : m_next(0), m_count(0), m_steps(0), m_log(nullptr) {}
+
+SimulationStats::~SimulationStats()
+{
+	closeLog();
+}
+
+bool SimulationStats::openLog(const char* a_filename)
+{
+	closeLog();
+
+	m_log = fopen(a_filename, "w");
+	if (m_log == nullptr)
+	{
+		printf("Error: Failed to open %s for writing\n", a_filename);
+		return false;
+	}
+
+	fprintf(m_log, "step,active_bodies,dynamic_bodies,static_bodies,active_constraints,axis_constraints,contact_pairs,"
+		"broadphase_volumes,broadphase_adds,broadphase_removes,contact_memory,actors,aggregates,gizmo_lines,gizmo_tris,"
+		"draw_calls,fetch_wait_ms\n");
+
+	return true;
+}
+
+void SimulationStats::printLegend()
+{
+	//the overlay has no text, so say which colour is which once
+	printf("Stats overlay, top to bottom:");
+	for (unsigned int i = 0; i < s_seriesCount; i++)
+		printf("%s %s", i > 0 ? "," : "", s_series[i].name);
+	printf("\n");
+}
+
+void SimulationStats::closeLog()
+{
+	if (m_log != nullptr)
+		fclose(m_log);
+	m_log = nullptr;
+}
+
+void SimulationStats::record(const PxScene* a_scene, Sample& a_sample)
+{
+	PxSimulationStatistics stats;
+	a_scene->getSimulationStatistics(stats);
+
+	a_sample.step = m_steps++;
+	a_sample.activeBodies = stats.nbActiveDynamicBodies + stats.nbActiveKinematicBodies;
+	a_sample.dynamicBodies = stats.nbDynamicBodies;
+	a_sample.staticBodies = stats.nbStaticBodies;
+	a_sample.activeConstraints = stats.nbActiveConstraints;
+	a_sample.axisConstraints = stats.nbAxisSolverConstraints;
+	a_sample.contactPairs = stats.totalDiscreteContactPairsAnyShape;
+
+	unsigned int shapes = 0;
+	for (unsigned int i = 0; i < PxGeometryType::eGEOMETRY_COUNT; i++)
+		shapes += stats.nbShapes[i];
+	a_sample.broadphaseVolumes = shapes - PxMin(shapes, a_sample.aggregatedShapes) + a_sample.aggregates;
+
+	a_sample.broadphaseAdds = stats.getNbBroadPhaseAdds(PxSimulationStatistics::eRIGID_BODY);
+	a_sample.broadphaseRemoves = stats.getNbBroadPhaseRemoves(PxSimulationStatistics::eRIGID_BODY);
+	a_sample.contactMemory = stats.requiredContactConstraintMemory;
+
+	m_history[m_next] = a_sample;
+	m_next = (m_next + 1) % HISTORY_SIZE;
+	if (m_count < HISTORY_SIZE)
+		m_count++;
+
+	if (m_log != nullptr)
+	{
+		fprintf(m_log, "%u,%u,%u,%u,%u,%u,%u,%u,%u,%u,%u,%u,%u,%u,%u,%u,%.4f\n",
+			a_sample.step, a_sample.activeBodies, a_sample.dynamicBodies, a_sample.staticBodies,
+			a_sample.activeConstraints, a_sample.axisConstraints, a_sample.contactPairs, a_sample.broadphaseVolumes,
+			a_sample.broadphaseAdds, a_sample.broadphaseRemoves, a_sample.contactMemory, a_sample.actors,
+			a_sample.aggregates, a_sample.gizmoLines, a_sample.gizmoTris, a_sample.drawCalls, a_sample.fetchWaitMs);
+	}
+}
+
+const SimulationStats::Sample& SimulationStats::getSample(unsigned int a_age) const
+{
+	return m_history[(m_next + HISTORY_SIZE - 1 - a_age) % HISTORY_SIZE];
+}
+
+void SimulationStats::addOverlay(const glm::vec2& a_topLeft) const
+{
+	if (m_count < 2)
+		return;
+
+	const float graphWidth = 2.0f * HISTORY_SIZE;
+	const float graphHeight = 24.0f;
+	const float gap = 4.0f;
+	float height = (graphHeight + gap) * s_seriesCount;
+
+	//background
+	Gizmos::add2DAABBFilled(a_topLeft + vec2(graphWidth, -height) * 0.5f, vec2(graphWidth, height) * 0.5f, vec4(0, 0, 0, 0.5f));
+
+	float step = graphWidth / (HISTORY_SIZE - 1);
+
+	for (unsigned int i = 0; i < s_seriesCount; i++)
+	{
+		const Series& series = s_series[i];
+		vec2 bottomRight = a_topLeft + vec2(graphWidth, -(i + 1) * (graphHeight + gap) + gap * 0.5f);
+
+		//scale to the peak so a slow climb is as visible as a spike
+		float peak = 0;
+		for (unsigned int age = 0; age < m_count; age++)
+			peak = glm::max(peak, series.value(getSample(age)));
+
+		float scale = peak > 0 ? graphHeight / peak : 0;
+
+		//newest on the right
+		vec2 previous = bottomRight + vec2(0, series.value(getSample(0)) * scale);
+		for (unsigned int age = 1; age < m_count; age++)
+		{
+			vec2 point = bottomRight + vec2(-step * age, series.value(getSample(age)) * scale);
+			Gizmos::add2DLine(previous, point, series.colour);
+			previous = point;
+		}
+	}
+}
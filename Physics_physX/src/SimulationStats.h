@@ -0,0 +1,78 @@
+#ifndef _SIMULATIONSTATS_H_
+#define _SIMULATIONSTATS_H_
+
+#include <PxPhysicsAPI.h>
+
+#include <cstdio>
+
+#include "glm_includes.h"
+
+using namespace physx;
+
+//keeps a rolling history of PxSimulationStatistics alongside our own per frame counters so
+//growth in pairs, contacts or draw calls shows up as it happens. the history can be logged
+//to CSV every sample and drawn as a stack of small line graphs with Gizmos.
+class SimulationStats
+{
+public:
+	struct Sample
+	{
+		unsigned int	step;
+
+		//from PhysX
+		unsigned int	activeBodies;		// awake dynamics and kinematics
+		unsigned int	dynamicBodies;
+		unsigned int	staticBodies;
+		unsigned int	activeConstraints;
+		unsigned int	axisConstraints;	// solver rows, tracks solver cost
+		unsigned int	contactPairs;		// discrete contact pairs of any shape
+		unsigned int	broadphaseVolumes;	// shapes outside aggregates plus one per aggregate
+		unsigned int	broadphaseAdds;
+		unsigned int	broadphaseRemoves;
+		unsigned int	contactMemory;		// bytes, requiredContactConstraintMemory
+
+		//ours
+		unsigned int	actors;				// g_PhysXActors
+		unsigned int	aggregates;
+		unsigned int	aggregatedShapes;
+		unsigned int	gizmoLines;
+		unsigned int	gizmoTris;
+		unsigned int	drawCalls;
+		float			fetchWaitMs;
+	};
+
+	//samples kept for the graphs
+	static const unsigned int HISTORY_SIZE = 128;
+
+	SimulationStats();
+	~SimulationStats();
+
+	//starts appending every sample to a_filename
+	bool openLog(const char* a_filename);
+	void closeLog();
+
+	//fills in the PhysX half of a_sample from a_scene's last step and adds it to the history,
+	//our half has to be filled in first as the broadphase volumes depend on the aggregate counts
+	void record(const PxScene* a_scene, Sample& a_sample);
+
+	unsigned int getSampleCount() const { return m_count; }
+
+	//a_age 0 is the latest sample
+	const Sample& getSample(unsigned int a_age) const;
+
+	//one graph per counter, each scaled to its own peak in the history
+	void addOverlay(const glm::vec2& a_topLeft) const;
+
+	//prints the names of addOverlay's graphs in the order they are drawn
+	static void printLegend();
+
+private:
+	Sample m_history[HISTORY_SIZE];
+	unsigned int m_next;
+	unsigned int m_count;
+	unsigned int m_steps;
+
+	FILE* m_log;
+};
+
+#endif // !_SIMULATIONSTATS_H_
@@ -0,0 +1,64 @@
+#ifndef _SPSCQUEUE_H_
+#define _SPSCQUEUE_H_
+
+#include <atomic>
+#include <vector>
+
+//fixed size single producer, single consumer queue. one thread may push while another pops
+//without any locking. push fails rather than grow once the queue is full.
+template <typename T>
+class SpscQueue
+{
+public:
+	SpscQueue() : m_mask(0), m_head(0), m_tail(0) {}
+
+	//a_capacity is rounded up to a power of two, call before either thread uses the queue
+	void create(unsigned int a_capacity)
+	{
+		unsigned int capacity = 1;
+		while (capacity < a_capacity)
+			capacity <<= 1;
+
+		m_items.resize(capacity);
+		m_mask = capacity - 1;
+		m_head.store(0);
+		m_tail.store(0);
+	}
+
+	//producer only
+	bool push(const T& a_item)
+	{
+		unsigned int tail = m_tail.load(std::memory_order_relaxed);
+		if (tail - m_head.load(std::memory_order_acquire) == m_items.size())
+			return false;
+
+		m_items[tail & m_mask] = a_item;
+		m_tail.store(tail + 1, std::memory_order_release);
+		return true;
+	}
+
+	//consumer only
+	bool pop(T& a_item)
+	{
+		unsigned int head = m_head.load(std::memory_order_relaxed);
+		if (head == m_tail.load(std::memory_order_acquire))
+			return false;
+
+		a_item = m_items[head & m_mask];
+		m_head.store(head + 1, std::memory_order_release);
+		return true;
+	}
+
+private:
+	std::vector<T> m_items;
+	unsigned int m_mask;
+
+	//kept on separate cache lines so the two threads don't fight over them
+	char m_pad0[64];
+	std::atomic<unsigned int> m_head;	//next item to pop, written by the consumer
+	char m_pad1[64];
+	std::atomic<unsigned int> m_tail;	//next free slot, written by the producer
+	char m_pad2[64];
+};
+
+#endif // !_SPSCQUEUE_H_
@@ -0,0 +1,227 @@
+#include "TaskPool.h"
+#include "Profiler.h"
+
+TaskPool::TaskPool() : m_running(false), m_queuedJobs(0), m_nextQueue(0) {}
+TaskPool::~TaskPool()
+{
+	shutdown();
+}
+
+void TaskPool::startup(unsigned int a_workerCount)
+{
+	if (m_running)
+		return;
+
+	//one worker per core, leave one for the main thread
+	if (a_workerCount == 0)
+	{
+		unsigned int cores = std::thread::hardware_concurrency();
+		a_workerCount = cores > 1 ? cores - 1 : 1;
+	}
+
+	m_running = true;
+
+	//one queue per worker
+	for (unsigned int i = 0; i < a_workerCount; i++)
+	{
+		m_queues.push_back(new WorkQueue());
+	}
+
+	for (unsigned int i = 0; i < a_workerCount; i++)
+	{
+		m_workers.push_back(std::thread(&TaskPool::workerLoop, this, i));
+	}
+}
+
+void TaskPool::shutdown()
+{
+	if (m_running == false)
+		return;
+
+	//wake everyone up so they can see we are stopping
+	{
+		std::lock_guard<std::mutex> lock(m_wakeLock);
+		m_running = false;
+	}
+	m_wake.notify_all();
+
+	for (auto& worker : m_workers)
+	{
+		worker.join();
+	}
+	m_workers.clear();
+
+	for (auto queue : m_queues)
+	{
+		delete queue;
+	}
+	m_queues.clear();
+}
+
+void TaskPool::submit(JobFunction a_function, void* a_data, JobCounter* a_counter,
+					  unsigned int a_begin, unsigned int a_end)
+{
+	Job job;
+	job.function = a_function;
+	job.data = a_data;
+	job.begin = a_begin;
+	job.end = a_end;
+	job.counter = a_counter;
+
+	if (a_counter != nullptr)
+		a_counter->pending++;
+
+	//no workers, just run it here
+	if (m_workers.empty())
+	{
+		execute(job);
+		return;
+	}
+
+	//workers push onto their own queue, everyone else spreads jobs across the workers
+	int worker = getWorkerIndex();
+	unsigned int queue = worker >= 0 ? (unsigned int)worker : m_nextQueue++ % m_queues.size();
+
+	//queue full, run it here rather than block
+	if (pushJob(queue, job) == false)
+	{
+		execute(job);
+		return;
+	}
+
+	m_queuedJobs++;
+
+	//take the lock so a worker can't miss the wake up between checking and sleeping
+	{
+		std::lock_guard<std::mutex> lock(m_wakeLock);
+	}
+	m_wake.notify_one();
+}
+
+void TaskPool::wait(JobCounter& a_counter)
+{
+	int worker = getWorkerIndex();
+
+	while (a_counter.pending > 0)
+	{
+		//help out rather than sit idle
+		Job job;
+		if (findJob(worker, job))
+			execute(job);
+		else
+			std::this_thread::yield();
+	}
+}
+
+void TaskPool::workerLoop(unsigned int a_index)
+{
+	Profiler::setThreadName("Worker");
+
+	while (m_running)
+	{
+		Job job;
+		if (findJob(a_index, job))
+		{
+			execute(job);
+			continue;
+		}
+
+		//nothing to do, sleep until something is submitted
+		std::unique_lock<std::mutex> lock(m_wakeLock);
+		m_wake.wait(lock, [this]() { return m_running == false || m_queuedJobs > 0; });
+	}
+}
+
+bool TaskPool::pushJob(unsigned int a_queue, const Job& a_job)
+{
+	WorkQueue& queue = *m_queues[a_queue];
+	std::lock_guard<std::mutex> lock(queue.lock);
+
+	if (queue.tail - queue.head >= QUEUE_SIZE)
+		return false;
+
+	queue.jobs[queue.tail % QUEUE_SIZE] = a_job;
+	queue.tail++;
+
+	return true;
+}
+
+bool TaskPool::popJob(unsigned int a_queue, Job& a_job)
+{
+	WorkQueue& queue = *m_queues[a_queue];
+	std::lock_guard<std::mutex> lock(queue.lock);
+
+	if (queue.tail == queue.head)
+		return false;
+
+	//newest first, its data is most likely still in cache
+	queue.tail--;
+	a_job = queue.jobs[queue.tail % QUEUE_SIZE];
+
+	return true;
+}
+
+bool TaskPool::stealJob(unsigned int a_queue, Job& a_job)
+{
+	WorkQueue& queue = *m_queues[a_queue];
+	std::lock_guard<std::mutex> lock(queue.lock);
+
+	if (queue.tail == queue.head)
+		return false;
+
+	//oldest first, least likely to be contended by the owner
+	a_job = queue.jobs[queue.head % QUEUE_SIZE];
+	queue.head++;
+
+	return true;
+}
+
+bool TaskPool::findJob(int a_worker, Job& a_job)
+{
+	//our own queue first
+	if (a_worker >= 0 && popJob(a_worker, a_job))
+	{
+		m_queuedJobs--;
+		return true;
+	}
+
+	//then steal, starting with our neighbour so thieves spread out
+	unsigned int queueCount = (unsigned int)m_queues.size();
+	unsigned int first = a_worker >= 0 ? a_worker + 1 : 0;
+
+	for (unsigned int i = 0; i < queueCount; i++)
+	{
+		unsigned int victim = (first + i) % queueCount;
+		if ((int)victim == a_worker)
+			continue;
+
+		if (stealJob(victim, a_job))
+		{
+			m_queuedJobs--;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void TaskPool::execute(const Job& a_job)
+{
+	a_job.function(a_job.data, a_job.begin, a_job.end);
+
+	if (a_job.counter != nullptr)
+		a_job.counter->pending--;
+}
+
+int TaskPool::getWorkerIndex() const
+{
+	std::thread::id self = std::this_thread::get_id();
+
+	for (unsigned int i = 0; i < m_workers.size(); i++)
+	{
+		if (m_workers[i].get_id() == self)
+			return i;
+	}
+
+	return -1;
+}
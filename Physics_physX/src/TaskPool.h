@@ -0,0 +1,131 @@
+#ifndef _TASKPOOL_H_
+#define _TASKPOOL_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+//tracks a group of jobs so the submitter can wait on them
+struct JobCounter
+{
+	JobCounter() : pending(0) {}
+
+	std::atomic<int> pending;
+};
+
+//work-stealing thread pool, shared by PhysX and the app's own per-frame jobs
+class TaskPool
+{
+public:
+	//a job runs over the range [a_begin, a_end)
+	typedef void(*JobFunction)(void* a_data, unsigned int a_begin, unsigned int a_end);
+
+	TaskPool();
+	~TaskPool();
+
+	//a_workerCount of 0 uses one worker per core, minus one for the main thread
+	void startup(unsigned int a_workerCount = 0);
+	void shutdown();
+
+	unsigned int getWorkerCount() const { return (unsigned int)m_workers.size(); }
+
+	//queue a job, the counter (if any) is decremented once it has run
+	void submit(JobFunction a_function, void* a_data, JobCounter* a_counter = nullptr,
+				unsigned int a_begin = 0, unsigned int a_end = 0);
+
+	//run queued jobs on the calling thread until the counter reaches zero
+	void wait(JobCounter& a_counter);
+
+	//split [0, a_count) into batches and run a_function(index) on each, returns once all are done
+	template<typename F>
+	void parallelFor(unsigned int a_count, unsigned int a_batchSize, const F& a_function);
+
+private:
+	struct Job
+	{
+		JobFunction function;
+		void* data;
+		unsigned int begin;
+		unsigned int end;
+		JobCounter* counter;
+	};
+
+	//fixed size so submitting never allocates
+	static const unsigned int QUEUE_SIZE = 1024;
+
+	struct WorkQueue
+	{
+		WorkQueue() : head(0), tail(0) {}
+
+		std::mutex lock;
+		Job jobs[QUEUE_SIZE];
+		unsigned int head;	//oldest job, stolen by other threads
+		unsigned int tail;	//newest job, taken by the owner
+	};
+
+	void workerLoop(unsigned int a_index);
+
+	bool pushJob(unsigned int a_queue, const Job& a_job);
+	bool popJob(unsigned int a_queue, Job& a_job);
+	bool stealJob(unsigned int a_queue, Job& a_job);
+	bool findJob(int a_worker, Job& a_job);	//a_worker of -1 only steals
+
+	void execute(const Job& a_job);
+
+	int getWorkerIndex() const;	//-1 if not called from a worker
+
+	template<typename F>
+	static void runBatch(void* a_data, unsigned int a_begin, unsigned int a_end);
+
+	std::vector<std::thread> m_workers;
+	std::vector<WorkQueue*> m_queues;
+
+	std::atomic<bool> m_running;
+	std::atomic<int> m_queuedJobs;
+	std::atomic<unsigned int> m_nextQueue;
+
+	std::mutex m_wakeLock;
+	std::condition_variable m_wake;
+};
+
+template<typename F>
+void TaskPool::runBatch(void* a_data, unsigned int a_begin, unsigned int a_end)
+{
+	const F& function = *(const F*)a_data;
+
+	for (unsigned int i = a_begin; i < a_end; i++)
+	{
+		function(i);
+	}
+}
+
+template<typename F>
+void TaskPool::parallelFor(unsigned int a_count, unsigned int a_batchSize, const F& a_function)
+{
+	if (a_batchSize == 0)
+		a_batchSize = 1;
+
+	//not worth handing out, or nobody to hand it to
+	if (m_workers.empty() || a_count <= a_batchSize)
+	{
+		runBatch<F>((void*)&a_function, 0, a_count);
+		return;
+	}
+
+	JobCounter counter;
+
+	for (unsigned int begin = 0; begin < a_count; begin += a_batchSize)
+	{
+		unsigned int end = begin + a_batchSize;
+		if (end > a_count)
+			end = a_count;
+
+		submit(&TaskPool::runBatch<F>, (void*)&a_function, &counter, begin, end);
+	}
+
+	wait(counter);
+}
+
+#endif // !_TASKPOOL_H_
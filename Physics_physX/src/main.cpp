@@ -1,17 +1,116 @@
 #include "PhysicsDemoScene.h"
+#include "Benchmark.h"
 
-int main()
+#include <cstdlib>
+#include <cstring>
+
+int main(int argc, char** argv)
 {
 	PhysicsDemoScene app;
 
+	const char* benchmark = nullptr;
+	const char* csvFile = nullptr;
+	const char* jsonFile = nullptr;
+	const char* summariseFile = nullptr;
+
+	//command line options
+	//	--headless			step the physics without a window or GL context
+	//	--steps N			how many fixed steps a headless or benchmark run takes
+	//	--threads N			worker threads, 0 for one per core
+	//	--benchmark NAME	run a benchmark scenario, or all of them, then exit
+	//	--csv FILE			write the benchmark results as CSV
+	//	--json FILE			write the benchmark results as JSON
+	//	--profile			time the frame and show the averages on screen
+	//	--trace FILE		profile and write a Chrome trace on exit
+	//	--capture FILE		write PhysX profile events to FILE.pxprof and PVD data to FILE.pxd2
+	//	--capture-limit MB	most each capture file may grow to, 64 by default
+	//	--summarise FILE	print per stage timings from a .pxprof capture then exit
+	//	--stats				graph the simulation statistics on screen
+	//	--stats-csv FILE	log the simulation statistics after every step
+	//	--broadphase TYPE	sap or mbp
+	//	--world-size N		half the width of the world, things leaving it are despawned
+	//	--world-subdiv N	MBP regions along each side of the world
+	//	--aggregate N		group compounds and related actors into aggregates of up to N actors
+	//	--assert-no-alloc	assert once the scene has settled if a frame allocates on the main thread (debug builds)
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "--headless") == 0)
+			app.m_headless = true;
+		else if (strcmp(argv[i], "--steps") == 0 && i + 1 < argc)
+			app.m_headlessSteps = (unsigned int)atoi(argv[++i]);
+		else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+			app.m_workerThreads = (unsigned int)atoi(argv[++i]);
+		else if (strcmp(argv[i], "--benchmark") == 0 && i + 1 < argc)
+			benchmark = argv[++i];
+		else if (strcmp(argv[i], "--csv") == 0 && i + 1 < argc)
+			csvFile = argv[++i];
+		else if (strcmp(argv[i], "--json") == 0 && i + 1 < argc)
+			jsonFile = argv[++i];
+		else if (strcmp(argv[i], "--profile") == 0)
+			app.m_profile = true;
+		else if (strcmp(argv[i], "--trace") == 0 && i + 1 < argc)
+			app.m_traceFile = argv[++i];
+		else if (strcmp(argv[i], "--capture") == 0 && i + 1 < argc)
+			app.m_captureFile = argv[++i];
+		else if (strcmp(argv[i], "--capture-limit") == 0 && i + 1 < argc)
+			app.m_captureLimit = (size_t)atoi(argv[++i]) << 20;
+		else if (strcmp(argv[i], "--summarise") == 0 && i + 1 < argc)
+			summariseFile = argv[++i];
+		else if (strcmp(argv[i], "--stats") == 0)
+			app.m_showStats = true;
+		else if (strcmp(argv[i], "--stats-csv") == 0 && i + 1 < argc)
+			app.m_statsFile = argv[++i];
+		else if (strcmp(argv[i], "--broadphase") == 0 && i + 1 < argc)
+			app.m_broadPhaseType = strcmp(argv[++i], "mbp") == 0 ? PxBroadPhaseType::eMBP : PxBroadPhaseType::eSAP;
+		else if (strcmp(argv[i], "--world-size") == 0 && i + 1 < argc)
+		{
+			float size = (float)atof(argv[++i]);
+			app.m_worldBounds = PxBounds3(PxVec3(-size), PxVec3(size));
+		}
+		else if (strcmp(argv[i], "--world-subdiv") == 0 && i + 1 < argc)
+			app.m_worldSubdivisions = (unsigned int)atoi(argv[++i]);
+		else if (strcmp(argv[i], "--aggregate") == 0 && i + 1 < argc)
+			app.m_aggregateSize = (unsigned int)atoi(argv[++i]);
+		else if (strcmp(argv[i], "--assert-no-alloc") == 0)
+			app.m_assertNoFrameAllocations = true;
+	}
+
+	//reading a capture back doesn't need a scene
+	if (summariseFile != nullptr)
+		return ProfileCapture::summarise(summariseFile) ? 0 : -1;
+
+	//benchmarks build their own headless scenes
+	if (benchmark != nullptr)
+	{
+		Benchmark suite;
+		if (suite.run(benchmark, app.m_headlessSteps, app.m_workerThreads) == false)
+			return -1;
+
+		suite.print();
+
+		if (csvFile != nullptr && suite.writeCSV(csvFile) == false)
+			return -1;
+		if (jsonFile != nullptr && suite.writeJSON(jsonFile) == false)
+			return -1;
+
+		return 0;
+	}
+
 	//if startup fails end program
 	if (app.startup() == false)
 		return -1;
 
-	//update and draw
-	while (app.update() == true)
+	if (app.m_headless)
+	{
+		app.runHeadless(app.m_headlessSteps);
+	}
+	else
 	{
-		app.draw();
+		//update and draw
+		while (app.update() == true)
+		{
+			app.draw();
+		}
 	}
 
 	//shutdown
@@ -12,6 +12,7 @@ namespace ShaderObjs
 		unsigned int VBO;
 		unsigned int IBO;
 		unsigned int IndexCount;
+		unsigned int IndexType;		//GL_UNSIGNED_SHORT or GL_UNSIGNED_INT
 	};
 
 }